@@ -0,0 +1,324 @@
+// Micro-benchmarks for the hot paths of DBPFKit. Every measurement runs a fixed number of operations per sample
+// and reports the per-operation time over all samples as min/median/p99, plus MB/s where a byte count applies.
+//
+//   DBPFKitBench [--samples N] [--filter SUBSTRING] [--json PATH|-]
+//
+// With --json - the JSON goes to stdout and the table to stderr.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DBPFReader.h"
+#include "DBPFWriter.h"
+#include "ExemplarReader.h"
+#include "FSHReader.h"
+#include "QFSCompressor.h"
+#include "QFSDecompressor.h"
+#include "S3DReader.h"
+#include "SyntheticCorpus.h"
+#include "TGI.h"
+
+namespace {
+
+    struct Options {
+        size_t samples = 25;
+        std::string filter;
+        std::string jsonPath;
+    };
+
+    struct Result {
+        std::string name;
+        size_t opsPerSample = 0;
+        double bytesPerOp = 0.0;
+        double minNs = 0.0;
+        double medianNs = 0.0;
+        double p99Ns = 0.0;
+
+        [[nodiscard]] double MegabytesPerSecond() const {
+            return bytesPerOp > 0.0 && medianNs > 0.0 ? bytesPerOp / medianNs * 1e9 / (1024.0 * 1024.0) : 0.0;
+        }
+    };
+
+    // Keeps the optimizer from discarding the measured work.
+    volatile size_t gSink = 0;
+
+    class Harness {
+    public:
+        explicit Harness(Options options)
+            : mOptions(std::move(options)) {}
+
+        // body runs opsPerSample operations and returns a value that depends on their results.
+        void Run(std::string_view name, const size_t opsPerSample, const double bytesPerOp,
+                 const std::function<size_t()>& body) {
+            if (!mOptions.filter.empty() && name.find(mOptions.filter) == std::string_view::npos) {
+                return;
+            }
+
+            // The warm-up doubles as a check that the inputs are valid.
+            const size_t warmUp = body();
+            if (warmUp == 0) {
+                std::println(TableStream(), "{:<24} FAILED", name);
+                mFailed = true;
+                return;
+            }
+            gSink = gSink + warmUp;
+            std::vector<double> perOp;
+            perOp.reserve(mOptions.samples);
+            for (size_t sample = 0; sample < mOptions.samples; ++sample) {
+                const auto start = std::chrono::steady_clock::now();
+                gSink = gSink + body();
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                perOp.push_back(std::chrono::duration<double, std::nano>(elapsed).count() /
+                                static_cast<double>(opsPerSample));
+            }
+            std::ranges::sort(perOp);
+
+            Result result{std::string(name), opsPerSample, bytesPerOp};
+            result.minNs = perOp.front();
+            result.medianNs = perOp[perOp.size() / 2];
+            const size_t p99Rank = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(perOp.size())));
+            result.p99Ns = perOp[std::max<size_t>(p99Rank, 1) - 1];
+
+            if (result.bytesPerOp > 0.0) {
+                std::println(TableStream(),
+                             "{:<24} min {:>12.1f} ns  median {:>12.1f} ns  p99 {:>12.1f} ns  {:>9.1f} MB/s",
+                             result.name, result.minNs, result.medianNs, result.p99Ns, result.MegabytesPerSecond());
+            }
+            else {
+                std::println(TableStream(), "{:<24} min {:>12.1f} ns  median {:>12.1f} ns  p99 {:>12.1f} ns",
+                             result.name, result.minNs, result.medianNs, result.p99Ns);
+            }
+            mResults.push_back(std::move(result));
+        }
+
+        [[nodiscard]] bool Failed() const { return mFailed; }
+
+        [[nodiscard]] bool WriteJson() const {
+            if (mOptions.jsonPath.empty()) {
+                return true;
+            }
+
+            std::string json = std::format("{{\n  \"samples\": {},\n  \"benchmarks\": [\n", mOptions.samples);
+            for (size_t i = 0; i < mResults.size(); ++i) {
+                const auto& result = mResults[i];
+                json += std::format("    {{\"name\": \"{}\", \"ops_per_sample\": {}, \"min_ns\": {:.3f}, "
+                                    "\"median_ns\": {:.3f}, \"p99_ns\": {:.3f}",
+                                    result.name, result.opsPerSample, result.minNs, result.medianNs, result.p99Ns);
+                if (result.bytesPerOp > 0.0) {
+                    json += std::format(", \"bytes_per_op\": {:.0f}, \"mb_per_s\": {:.3f}",
+                                        result.bytesPerOp, result.MegabytesPerSecond());
+                }
+                json += i + 1 < mResults.size() ? "},\n" : "}\n";
+            }
+            json += "  ]\n}\n";
+
+            if (mOptions.jsonPath == "-") {
+                std::print("{}", json);
+                return true;
+            }
+            std::ofstream out(mOptions.jsonPath, std::ios::binary | std::ios::trunc);
+            out << json;
+            if (!out) {
+                std::println(stderr, "Failed to write {}", mOptions.jsonPath);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        // With --json - stdout carries only the JSON, so the table moves to stderr.
+        [[nodiscard]] std::FILE* TableStream() const {
+            return mOptions.jsonPath == "-" ? stderr : stdout;
+        }
+
+        Options mOptions;
+        std::vector<Result> mResults;
+        bool mFailed = false;
+    };
+
+    std::vector<uint8_t> CompressibleBytes(const size_t size, const uint64_t seed) {
+        static constexpr std::string_view kWords[] = {"Exemplar ", "Building ", "Lot ", "Prop ", "Texture "};
+        Synthetic::Rng rng(seed);
+        std::vector<uint8_t> data;
+        data.reserve(size + 16);
+        while (data.size() < size) {
+            const uint64_t value = rng.Next();
+            if ((value >> 60) == 0) {
+                data.push_back(static_cast<uint8_t>(value >> 8));
+                continue;
+            }
+            const auto word = kWords[(value >> 8) % std::size(kWords)];
+            data.insert(data.end(), word.begin(), word.end());
+        }
+        data.resize(size);
+        return data;
+    }
+
+    bool ParseArguments(const int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--samples" && hasValue) {
+                options.samples = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else if (arg == "--filter" && hasValue) {
+                options.filter = argv[++i];
+            }
+            else if (arg == "--json" && hasValue) {
+                options.jsonPath = argv[++i];
+            }
+            else {
+                std::println("Usage: {} [--samples N] [--filter SUBSTRING] [--json PATH|-]", argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArguments(argc, argv, options)) {
+        return 1;
+    }
+    Harness harness(options);
+
+    // Small exemplar and LText entries keep the archive index-heavy, like a typical plugin.
+    constexpr size_t kArchiveEntries = 50000;
+    const auto archivePath = std::filesystem::temp_directory_path() / "dbpfkit_bench.dat";
+    Synthetic::ArchiveSpec archiveSpec;
+    archiveSpec.entryCount = kArchiveEntries;
+    archiveSpec.mix = {90, 0, 0, 10};
+    archiveSpec.compressedFraction = 0.25;
+    if (!Synthetic::WriteArchive(archivePath, archiveSpec)) {
+        std::println(stderr, "Failed to write the benchmark archive");
+        return 1;
+    }
+
+    harness.Run("archive_open", 1, 0.0, [&] {
+        DBPF::Reader reader;
+        return reader.LoadFile(archivePath) ? reader.GetIndex().size() : 0;
+    });
+
+    DBPF::Reader reader;
+    if (!reader.LoadFile(archivePath)) {
+        std::println(stderr, "Failed to open the benchmark archive");
+        return 1;
+    }
+
+    // Mostly hits, with one probe in eight for an instance the archive does not contain.
+    const auto& index = reader.GetIndex();
+    std::vector<DBPF::Tgi> probes;
+    Synthetic::Rng rng(17);
+    for (int i = 0; i < 4096; ++i) {
+        auto tgi = index[rng.Below(static_cast<uint32_t>(index.size()))].tgi;
+        if (i % 8 == 0) {
+            tgi.instance = 0x20000000u + rng.Below(kArchiveEntries);
+        }
+        probes.push_back(tgi);
+    }
+    harness.Run("tgi_lookup", probes.size(), 0.0, [&] {
+        size_t found = 0;
+        for (const auto& tgi : probes) {
+            found += reader.FindEntry(tgi) != nullptr;
+        }
+        return found;
+    });
+
+    const std::vector<DBPF::TgiMask> masks{
+        {0x6534284A, std::nullopt, std::nullopt},
+        {std::nullopt, 0x6A000005, std::nullopt},
+        {0x6534284A, 0x6A000009, std::nullopt},
+        {std::nullopt, std::nullopt, 0x10000000u + 12345},
+    };
+    harness.Run("mask_query", masks.size(), 0.0, [&] {
+        size_t matched = 0;
+        for (const auto& mask : masks) {
+            matched += reader.FindEntries(mask).size();
+        }
+        return matched;
+    });
+
+    const auto plain = CompressibleBytes(4 * 1024 * 1024, 3);
+    const auto compressed = QFS::Compressor::Compress(plain);
+    if (!compressed) {
+        std::println(stderr, "Failed to compress the benchmark payload");
+        return 1;
+    }
+    std::vector<uint8_t> decompressed(plain.size());
+    harness.Run("qfs_decompress", 1, static_cast<double>(plain.size()), [&] {
+        const auto written = QFS::Decompressor::Decompress(*compressed, std::span<uint8_t>(decompressed));
+        return written ? *written : 0;
+    });
+
+    Synthetic::Rng payloadRng(5);
+    const auto binaryExemplar = Synthetic::MakeExemplar(payloadRng, 48);
+    harness.Run("exemplar_binary_parse", 1000, static_cast<double>(binaryExemplar.size()), [&] {
+        size_t properties = 0;
+        for (int i = 0; i < 1000; ++i) {
+            const auto record = Exemplar::Parse(binaryExemplar);
+            properties += record ? record->properties.size() : 0;
+        }
+        return properties;
+    });
+
+    // Most callers read one or two properties, which the lazy view decodes without building a Record.
+    harness.Run("exemplar_view_lookup", 1000, static_cast<double>(binaryExemplar.size()), [&] {
+        size_t found = 0;
+        for (int i = 0; i < 1000; ++i) {
+            const auto view = Exemplar::ExemplarView::Parse(binaryExemplar);
+            found += view && view->GetScalarAs<uint32_t>(0x00000010) ? 1 : 0;
+        }
+        return found;
+    });
+
+    const auto textExemplar = Synthetic::MakeTextExemplar(payloadRng, 48);
+    harness.Run("exemplar_text_parse", 200, static_cast<double>(textExemplar.size()), [&] {
+        size_t properties = 0;
+        for (int i = 0; i < 200; ++i) {
+            const auto record = Exemplar::Parse(textExemplar);
+            properties += record ? record->properties.size() : 0;
+        }
+        return properties;
+    });
+
+    // Any bytes are valid DXT1 blocks, so random data stands in for a real texture.
+    FSH::Bitmap bitmap;
+    bitmap.code = FSH::kCodeDXT1;
+    bitmap.width = 512;
+    bitmap.height = 512;
+    bitmap.data.resize(bitmap.ExpectedDataSize());
+    for (auto& byte : bitmap.data) {
+        byte = static_cast<uint8_t>(rng.Next() >> 56);
+    }
+    std::vector<uint8_t> rgba;
+    harness.Run("fsh_rgba_dxt1", 1, static_cast<double>(bitmap.width) * bitmap.height * 4, [&] {
+        return FSH::Reader::ConvertToRGBA8(bitmap, rgba) ? rgba.size() : 0;
+    });
+
+    const auto model = Synthetic::MakeS3D(payloadRng, 8, 1200);
+    harness.Run("s3d_parse", 20, static_cast<double>(model.size()), [&] {
+        size_t vertices = 0;
+        for (int i = 0; i < 20; ++i) {
+            const auto record = S3D::Reader::Parse(model);
+            vertices += record ? record->vertexBuffers.size() : 0;
+        }
+        return vertices;
+    });
+
+    std::error_code ec;
+    std::filesystem::remove(archivePath, ec);
+    return harness.WriteJson() && !harness.Failed() ? 0 : 1;
+}
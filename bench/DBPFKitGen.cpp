@@ -0,0 +1,157 @@
+// Writes deterministic synthetic archives or whole Plugins trees for benchmarks and stress tests.
+//
+//   DBPFKitGen archive OUT.dat [options]
+//   DBPFKitGen tree ROOT [--files N] [--per-directory N] [--min-entries N] [--max-entries N] [--threads N] [options]
+//
+// Options: --seed N, --entries N, --mix EXEMPLAR,FSH,S3D,LTEXT, --rul0, --compressibility X,
+//          --compressed-fraction X, --no-directory, --level fast|default|optimal, --instance-space N
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <print>
+#include <string>
+#include <string_view>
+
+#include "SyntheticCorpus.h"
+
+namespace {
+
+    void PrintUsage(const char* program) {
+        std::println("Usage: {} archive OUT.dat [options]", program);
+        std::println("       {} tree ROOT [--files N] [--per-directory N] [--min-entries N] [--max-entries N] "
+                     "[--threads N] [options]", program);
+        std::println("Options: --seed N, --entries N, --mix EXEMPLAR,FSH,S3D,LTEXT, --rul0, --compressibility X,");
+        std::println("         --compressed-fraction X, --no-directory, --level fast|default|optimal, "
+                     "--instance-space N");
+    }
+
+    bool ParseMix(std::string_view text, Synthetic::TypeMix& mix) {
+        uint32_t weights[4]{};
+        for (auto& weight : weights) {
+            const size_t comma = text.find(',');
+            const std::string part(text.substr(0, comma));
+            if (part.empty()) {
+                return false;
+            }
+            weight = static_cast<uint32_t>(std::stoul(part));
+            text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+        }
+        mix = {weights[0], weights[1], weights[2], weights[3]};
+        return true;
+    }
+
+    bool ParseLevel(std::string_view text, QFS::Compressor::Level& level) {
+        if (text == "fast") {
+            level = QFS::Compressor::Level::kFast;
+        }
+        else if (text == "default") {
+            level = QFS::Compressor::Level::kDefault;
+        }
+        else if (text == "optimal") {
+            level = QFS::Compressor::Level::kOptimal;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    bool ParseArguments(const int argc, char** argv, Synthetic::TreeSpec& spec) {
+        auto& archive = spec.archive;
+        for (int i = 3; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--rul0") {
+                archive.includeRul0 = true;
+            }
+            else if (arg == "--no-directory") {
+                archive.writeDirectory = false;
+            }
+            else if (!hasValue) {
+                return false;
+            }
+            else if (arg == "--seed") {
+                spec.seed = archive.seed = std::stoull(argv[++i], nullptr, 0);
+            }
+            else if (arg == "--entries") {
+                archive.entryCount = spec.minEntries = spec.maxEntries = std::stoul(argv[++i]);
+            }
+            else if (arg == "--mix") {
+                if (!ParseMix(argv[++i], archive.mix)) {
+                    return false;
+                }
+            }
+            else if (arg == "--compressibility") {
+                archive.compressibility = std::stod(argv[++i]);
+            }
+            else if (arg == "--compressed-fraction") {
+                archive.compressedFraction = std::stod(argv[++i]);
+            }
+            else if (arg == "--level") {
+                if (!ParseLevel(argv[++i], archive.level)) {
+                    return false;
+                }
+            }
+            else if (arg == "--instance-space") {
+                archive.instanceSpace = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 0));
+            }
+            else if (arg == "--files") {
+                spec.fileCount = std::stoul(argv[++i]);
+            }
+            else if (arg == "--per-directory") {
+                spec.filesPerDirectory = std::stoul(argv[++i]);
+            }
+            else if (arg == "--min-entries") {
+                spec.minEntries = std::stoul(argv[++i]);
+            }
+            else if (arg == "--max-entries") {
+                spec.maxEntries = std::stoul(argv[++i]);
+            }
+            else if (arg == "--threads") {
+                spec.threadCount = std::stoul(argv[++i]);
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    const std::string_view mode = argv[1];
+    const std::filesystem::path target = argv[2];
+
+    Synthetic::TreeSpec spec;
+    try {
+        if ((mode != "archive" && mode != "tree") || !ParseArguments(argc, argv, spec)) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    catch (const std::exception&) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto summary = mode == "archive" ? Synthetic::WriteArchive(target, spec.archive)
+                                           : Synthetic::WriteTree(target, spec);
+    if (!summary) {
+        std::println("Failed to write {}", target.string());
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::println("Wrote {} files, {} entries, {:.1f} MB in {:.2f} s ({:.1f} MB/s)", summary->files, summary->entries,
+                 static_cast<double>(summary->bytes) / (1024.0 * 1024.0), seconds,
+                 static_cast<double>(summary->bytes) / (1024.0 * 1024.0) / std::max(seconds, 1e-9));
+    return 0;
+}
@@ -1,8 +1,12 @@
 #include "DBPFReader.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <format>
+#include <memory>
 #include <print>
+#include <thread>
 
 #include "ExemplarReader.h"
 #include "FSHReader.h"
@@ -10,6 +14,8 @@
 #include "RUL0.h"
 #include "QFSDecompressor.h"
 #include "S3DReader.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 
 namespace {
 
@@ -18,6 +24,10 @@ namespace {
         (static_cast<uint32_t>('P') << 16) | (static_cast<uint32_t>('F') << 24);
     constexpr size_t kHeaderSize = 0x60;
     constexpr uint32_t kSupportedIndexType = 7;
+    // Entries closer together than this are prefetched as one range; reading the gap is cheaper than a seek.
+    constexpr uint64_t kPrefetchMergeGap = 64 * 1024;
+    // Enough to cover the longest chunk header plus the QFS signature that follows it.
+    constexpr uint32_t kCompressionProbeBytes = 32;
 
     uint32_t ReadUInt32LE(const uint8_t* data) {
         return static_cast<uint32_t>(data[0]) |
@@ -26,44 +36,6 @@ namespace {
             (static_cast<uint32_t>(data[3]) << 24);
     }
 
-} // namespace
-
-namespace DBPF {
-
-    bool Reader::LoadFile(const std::filesystem::path& path) {
-        mFileBuffer.clear();
-        mMappedFile.Close();
-        mDataSource = DataSource::kNone;
-
-        if (!mMappedFile.Open(path)) {
-            return false;
-        }
-
-        mDataSource = DataSource::kMappedFile;
-        if (!ParseMappedFile()) {
-            mMappedFile.Close();
-            mDataSource = DataSource::kNone;
-            return false;
-        }
-        return true;
-    }
-
-    bool Reader::LoadBuffer(const uint8_t* data, size_t size) {
-        if (!data || size < kHeaderSize) {
-            return false;
-        }
-
-        mMappedFile.Close();
-        mFileBuffer.assign(data, data + size);
-        mDataSource = DataSource::kBuffer;
-        if (!ParseBuffer(std::span<const uint8_t>(mFileBuffer.data(), mFileBuffer.size()))) {
-            mFileBuffer.clear();
-            mDataSource = DataSource::kNone;
-            return false;
-        }
-        return true;
-    }
-
     bool IsChunkHeader(const uint8_t* data, size_t size,
                        uint32_t& chunkHeaderSize, uint32_t& chunkBodySize) {
         if (size < 9) {
@@ -112,16 +84,15 @@ namespace DBPF {
         return false;
     }
 
-    std::optional<std::vector<uint8_t>> Reader::ReadEntryData(const IndexEntry& entry) const {
-        EntryData entryData;
-        if (!LoadEntryData(entry, entryData)) {
-            std::println("[DBPF] Invalid bounds for entry {} (offset {}, size {})",
-                          entry.tgi.ToString(), entry.offset, entry.size);
-            return std::nullopt;
-        }
+    std::span<const uint8_t> UnwrapEntryPayload(std::span<const uint8_t> raw) {
+        const uint8_t* dataStart = raw.data();
+        size_t dataSize = raw.size();
 
-        const uint8_t* dataStart = entryData.span.data();
-        size_t dataSize = entryData.span.size();
+        // The usual layout for compressed entries: the stored size, then the QFS stream.
+        if (dataSize >= 9 && ReadUInt32LE(dataStart) == dataSize &&
+            QFS::Decompressor::IsQFSCompressed(raw.subspan(4))) {
+            return raw.subspan(4);
+        }
 
         uint32_t chunkHeaderSize = 0;
         uint32_t chunkBodySize = 0;
@@ -131,72 +102,468 @@ namespace DBPF {
         }
 
         bool _ = AlignToQfsSignature(dataStart, dataSize);
+        return {dataStart, dataSize};
+    }
+
+    bool DecodeStreamedPayload(std::span<const uint8_t> raw, std::vector<uint8_t>& scratch,
+                               std::span<const uint8_t>& out, DBPF::ReaderStats* stats) {
+        const auto payload = UnwrapEntryPayload(raw);
+        if (!QFS::Decompressor::IsQFSCompressed(payload)) {
+            out = payload;
+            return true;
+        }
+
+        const uint32_t size = QFS::Decompressor::GetUncompressedSize(payload);
+        if (scratch.size() < size) {
+            scratch.resize(size);
+        }
+        const auto written = QFS::Decompressor::Decompress(payload, std::span<uint8_t>(scratch));
+        if (!written.has_value()) {
+            if (stats) {
+                stats->RecordDecompressFailure();
+            }
+            return false;
+        }
+        if (stats) {
+            stats->RecordDecompressed(payload.size(), *written);
+        }
+        out = std::span<const uint8_t>(scratch.data(), *written);
+        return true;
+    }
+
+    template <typename Result, typename Fn>
+    std::vector<Result> RunBatch(std::span<const DBPF::IndexEntry* const> entries, DBPF::ThreadPool* pool, Fn&& fn) {
+        std::vector<std::optional<Result>> slots(entries.size());
+        auto& workers = pool ? *pool : DBPF::ThreadPool::Shared();
+        workers.ParallelFor(entries.size(), [&](const size_t i) {
+            slots[i].emplace(fn(entries[i]));
+        });
+
+        std::vector<Result> results;
+        results.reserve(slots.size());
+        for (auto& slot : slots) {
+            results.push_back(std::move(*slot));
+        }
+        return results;
+    }
+
+    // Runs a typed loader and, when statistics are enabled, records its outcome and duration.
+    template <typename Load>
+    auto MeasureLoad(DBPF::ReaderStats* stats, const DBPF::ReaderStats::Parser parser, Load&& load) {
+        if (!stats) {
+            return load();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        auto result = load();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        stats->RecordParse(parser, result.has_value(),
+                           static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        return result;
+    }
+
+} // namespace
+
+namespace DBPF {
 
-        std::vector data(dataStart, dataStart + dataSize);
+    bool Reader::LoadFile(const std::filesystem::path& path, const io::MappedFile::MappingMode mode) {
+        DBPFKIT_TRACE_SCOPE("dbpf", "LoadFile");
+        ResetSource();
 
-        std::span<const uint8_t> dataSpan(data.data(), data.size());
+        if (!mMappedFile.Open(path, mode)) {
+            return false;
+        }
+
+        mDataSource = DataSource::kMappedFile;
+        if (!ParseMappedFile()) {
+            ResetSource();
+            return false;
+        }
+        return true;
+    }
+
+    bool Reader::LoadFile(const std::filesystem::path& path, const PrecomputedIndex& index,
+                          const io::MappedFile::MappingMode mode) {
+        ResetSource();
+        mIndex.clear();
+        mTgiIndex.Clear();
+        mHasDirectory = false;
+
+        if (!mMappedFile.Open(path, mode)) {
+            return false;
+        }
+
+        const uint64_t fileSize = mMappedFile.FileSize();
+        for (const auto& entry : index.entries) {
+            if (static_cast<uint64_t>(entry.offset) + entry.Size() > fileSize) {
+                std::println("[DBPF] Precomputed index does not fit {} ({} is out of bounds)",
+                             path.string(), entry.tgi.ToString());
+                ResetSource();
+                return false;
+            }
+        }
 
-        if (QFS::Decompressor::IsQFSCompressed(dataSpan)) {
-            std::vector<uint8_t> decompressed;
-            auto result = QFS::Decompressor::Decompress(dataSpan, decompressed);
+        mDataSource = DataSource::kMappedFile;
+        mHeader = index.header;
+        mIndex.reserve(index.entries.size());
+        for (const auto& entry : index.entries) {
+            mIndex.push_back(entry.Unpack());
+        }
+        mTgiIndex.Build(mIndex);
+        mHasDirectory = index.hasDirectory;
+        return true;
+    }
+
+    bool Reader::LoadBuffer(const uint8_t* data, size_t size) {
+        if (!data || size < kHeaderSize) {
+            return false;
+        }
+
+        ResetSource();
+        mFileBuffer.assign(data, data + size);
+        return AdoptBuffer(std::span<const uint8_t>(mFileBuffer.data(), mFileBuffer.size()));
+    }
+
+    bool Reader::LoadBorrowedBuffer(std::span<const uint8_t> data) {
+        if (!data.data() || data.size() < kHeaderSize) {
+            return false;
+        }
+
+        ResetSource();
+        return AdoptBuffer(data);
+    }
+
+    bool Reader::LoadSharedBuffer(std::shared_ptr<const std::byte[]> data, size_t size) {
+        if (!data || size < kHeaderSize) {
+            return false;
+        }
+
+        ResetSource();
+        mSharedBuffer = std::move(data);
+        return AdoptBuffer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(mSharedBuffer.get()), size));
+    }
+
+    void Reader::ResetSource() {
+        if (mEntryCache) {
+            mEntryCache->Clear();
+        }
+        mMappedFile.Close();
+        mFileBuffer.clear();
+        mSharedBuffer.reset();
+        mBufferView = {};
+        mDataSource = DataSource::kNone;
+    }
+
+    bool Reader::AdoptBuffer(std::span<const uint8_t> buffer) {
+        mBufferView = buffer;
+        mDataSource = DataSource::kBuffer;
+        if (!ParseBuffer(mBufferView)) {
+            ResetSource();
+            return false;
+        }
+        return true;
+    }
+
+    bool Reader::LoadEntryPayload(const IndexEntry& entry, EntryData& out) const {
+        if (!LoadEntryData(entry, out)) {
+            std::println("[DBPF] Invalid bounds for entry {} (offset {}, size {})",
+                          entry.tgi.ToString(), entry.offset, entry.size);
+            if (mStats) {
+                mStats->RecordReadFailure();
+            }
+            return false;
+        }
+        out.span = UnwrapEntryPayload(out.span);
+        return true;
+    }
+
+    std::optional<EntryView> Reader::ReadEntryView(const IndexEntry& entry) const {
+        // Only compressed entries are ever inserted, so only they are looked up: uncompressed reads stay off the
+        // cache lock and out of its miss count. The directory tells up front; without one, the payload does.
+        const bool cacheable = mEntryCache && IsCacheable(entry) &&
+            (!mHasDirectory || entry.decompressedSize.has_value());
+        if (cacheable && mHasDirectory) {
+            if (auto cached = FindCachedView(entry)) {
+                return cached;
+            }
+        }
+
+        EntryData entryData;
+        if (!LoadEntryPayload(entry, entryData)) {
+            return std::nullopt;
+        }
+
+        EntryView view;
+        view.mRange = std::move(entryData.mappedRange);
+        const auto payload = entryData.span;
+
+        if (QFS::Decompressor::IsQFSCompressed(payload)) {
+            if (cacheable && !mHasDirectory) {
+                if (auto cached = FindCachedView(entry)) {
+                    return cached;
+                }
+            }
+            auto result = QFS::Decompressor::Decompress(payload, view.mOwned);
             if (!result.has_value()) {
+                if (mStats) {
+                    mStats->RecordDecompressFailure();
+                }
                 return std::nullopt;
             }
-            return decompressed;
+            if (mStats) {
+                mStats->RecordDecompressed(payload.size(), view.mOwned.size());
+            }
+            view.mRange = {};
+            if (cacheable) {
+                view.mShared = mEntryCache->Insert(entry.tgi, std::move(view.mOwned));
+                view.mOwned = {};
+                view.mSpan = std::span<const uint8_t>(view.mShared->data(), view.mShared->size());
+            }
+            else {
+                view.mSpan = std::span<const uint8_t>(view.mOwned.data(), view.mOwned.size());
+            }
+            view.mDecompressed = true;
+            return view;
         }
-        return data;
+
+        view.mSpan = payload;
+        return view;
     }
 
-    std::optional<std::vector<uint8_t>> Reader::ReadEntryData(const Tgi& tgi) const {
+    std::optional<EntryView> Reader::ReadEntryView(const Tgi& tgi) const {
         const IndexEntry* entry = FindEntry(tgi);
         if (!entry) {
             return std::nullopt;
         }
-        return ReadEntryData(*entry);
+        return ReadEntryView(*entry);
     }
 
-    const IndexEntry* Reader::FindEntry(const Tgi& tgi) const {
-        const auto it = mTGIIndex.find(tgi);
-        if (it == mTGIIndex.end()) {
+    std::optional<std::vector<uint8_t>> Reader::ReadEntryData(const IndexEntry& entry) const {
+        auto view = ReadEntryView(entry);
+        if (!view) {
+            return std::nullopt;
+        }
+        if (view->mDecompressed && !view->mShared) {
+            return std::move(view->mOwned);
+        }
+        return std::vector<uint8_t>(view->mSpan.begin(), view->mSpan.end());
+    }
+
+    EntryCache::Buffer Reader::ReadEntryShared(const IndexEntry& entry) const {
+        auto view = ReadEntryView(entry);
+        if (!view) {
             return nullptr;
         }
-        return it->second;
+        if (view->mShared) {
+            return std::move(view->mShared);
+        }
+        if (view->mDecompressed) {
+            return std::make_shared<const std::vector<uint8_t>>(std::move(view->mOwned));
+        }
+        return std::make_shared<const std::vector<uint8_t>>(view->mSpan.begin(), view->mSpan.end());
     }
 
-    std::vector<const IndexEntry*> Reader::FindEntries(const TgiMask& mask) const {
-        std::vector<const IndexEntry*> matches;
-        auto pushIfMatches = [&](const IndexEntry* entry) {
-            if (entry && mask.Matches(entry->tgi)) {
-                matches.push_back(entry);
-            }
-        };
+    EntryCache::Buffer Reader::ReadEntryShared(const Tgi& tgi) const {
+        const IndexEntry* entry = FindEntry(tgi);
+        if (!entry) {
+            return nullptr;
+        }
+        return ReadEntryShared(*entry);
+    }
 
-        if (mask.type.has_value()) {
-            const auto [begin, end] = mTypeIndex.equal_range(*mask.type);
-            for (auto it = begin; it != end; ++it) {
-                pushIfMatches(it->second);
-            }
-            return matches;
+    std::optional<std::vector<uint8_t>> Reader::ReadEntryData(const Tgi& tgi) const {
+        const IndexEntry* entry = FindEntry(tgi);
+        if (!entry) {
+            return std::nullopt;
+        }
+        return ReadEntryData(*entry);
+    }
+
+    std::optional<std::pmr::vector<uint8_t>> Reader::ReadEntryData(const IndexEntry& entry,
+                                                                   std::pmr::memory_resource* resource) const {
+        EntryData entryData;
+        if (!LoadEntryPayload(entry, entryData)) {
+            return std::nullopt;
         }
 
-        if (mask.group.has_value()) {
-            const auto [begin, end] = mGroupIndex.equal_range(*mask.group);
-            for (auto it = begin; it != end; ++it) {
-                pushIfMatches(it->second);
+        std::pmr::vector<uint8_t> data(resource ? resource : std::pmr::get_default_resource());
+        if (QFS::Decompressor::IsQFSCompressed(entryData.span)) {
+            if (!QFS::Decompressor::Decompress(entryData.span, data).has_value()) {
+                if (mStats) {
+                    mStats->RecordDecompressFailure();
+                }
+                return std::nullopt;
+            }
+            if (mStats) {
+                mStats->RecordDecompressed(entryData.span.size(), data.size());
             }
-            return matches;
+            return data;
+        }
+        data.assign(entryData.span.begin(), entryData.span.end());
+        return data;
+    }
+
+    std::optional<size_t> Reader::ReadEntryInto(const IndexEntry& entry, std::span<uint8_t> out) const {
+        EntryData entryData;
+        if (!LoadEntryPayload(entry, entryData)) {
+            return std::nullopt;
         }
 
-        if (mask.instance.has_value()) {
-            const auto [begin, end] = mInstanceIndex.equal_range(*mask.instance);
-            for (auto it = begin; it != end; ++it) {
-                pushIfMatches(it->second);
+        const auto payload = entryData.span;
+        if (QFS::Decompressor::IsQFSCompressed(payload)) {
+            auto result = QFS::Decompressor::Decompress(payload, out);
+            if (!result.has_value()) {
+                std::println("[DBPF] Failed to decompress {}: {}", entry.tgi.ToString(), result.error().message);
+                if (mStats) {
+                    mStats->RecordDecompressFailure();
+                }
+                return std::nullopt;
+            }
+            if (mStats) {
+                mStats->RecordDecompressed(payload.size(), *result);
             }
-            return matches;
+            return *result;
+        }
+
+        if (out.size() < payload.size()) {
+            std::println("[DBPF] Buffer too small for {} (need {}, have {})",
+                          entry.tgi.ToString(), payload.size(), out.size());
+            return std::nullopt;
+        }
+        std::copy(payload.begin(), payload.end(), out.begin());
+        return payload.size();
+    }
+
+    std::optional<size_t> Reader::GetPayloadSize(const IndexEntry& entry) const {
+        if (entry.decompressedSize.has_value()) {
+            return *entry.decompressedSize;
+        }
+
+        EntryData entryData;
+        if (!LoadEntryPayload(entry, entryData)) {
+            return std::nullopt;
+        }
+        if (QFS::Decompressor::IsQFSCompressed(entryData.span)) {
+            return QFS::Decompressor::GetUncompressedSize(entryData.span);
+        }
+        return entryData.span.size();
+    }
+
+    uint32_t Reader::GetLargestEntrySize() const {
+        uint32_t largest = 0;
+        for (const auto& entry : mIndex) {
+            largest = std::max(largest, entry.GetSize());
+        }
+        return largest;
+    }
+
+    void Reader::SetEntryCacheCapacity(const size_t capacityBytes) {
+        if (capacityBytes == 0) {
+            mEntryCache.reset();
+        }
+        else if (mEntryCache) {
+            mEntryCache->SetCapacity(capacityBytes);
+        }
+        else {
+            mEntryCache = std::make_unique<EntryCache>(capacityBytes);
+        }
+    }
+
+    void Reader::SetStatsEnabled(const bool enabled) {
+        if (!enabled) {
+            mStats.reset();
+        }
+        else if (!mStats) {
+            mStats = std::make_unique<ReaderStats>();
+        }
+    }
+
+    bool Reader::IsCompressed(const IndexEntry& entry) const {
+        if (mHasDirectory) {
+            return entry.decompressedSize.has_value();
         }
+        return ProbeCompressed(entry);
+    }
 
+    std::optional<std::vector<PackedIndexEntry>> Reader::GetPackedIndex(const bool probeCompression) const {
+        std::vector<PackedIndexEntry> packed;
+        packed.reserve(mIndex.size());
         for (const auto& entry : mIndex) {
-            pushIfMatches(&entry);
+            std::optional<bool> compressed;
+            if (mHasDirectory || probeCompression) {
+                compressed = IsCompressed(entry);
+            }
+            auto packedEntry = PackedIndexEntry::Pack(entry, compressed);
+            if (!packedEntry) {
+                std::println("[DBPF] Entry {} is too large to pack ({} bytes)", entry.tgi.ToString(), entry.size);
+                return std::nullopt;
+            }
+            packed.push_back(*packedEntry);
+        }
+        return packed;
+    }
+
+    std::optional<EntryView> Reader::FindCachedView(const IndexEntry& entry) const {
+        auto cached = mEntryCache->Find(entry.tgi);
+        if (!cached) {
+            return std::nullopt;
+        }
+        EntryView view;
+        view.mSpan = std::span<const uint8_t>(cached->data(), cached->size());
+        view.mShared = std::move(cached);
+        view.mDecompressed = true;
+        return view;
+    }
+
+    bool Reader::IsCacheable(const IndexEntry& entry) const {
+        if (mIndex.empty() || &entry < mIndex.data() || &entry >= mIndex.data() + mIndex.size()) {
+            return false;
+        }
+        const auto first = mTgiIndex.Find(entry.tgi);
+        return first && *first == static_cast<uint32_t>(&entry - mIndex.data());
+    }
+
+    bool Reader::ProbeCompressed(const IndexEntry& entry) const {
+        IndexEntry head = entry;
+        head.size = std::min(entry.size, kCompressionProbeBytes);
+        EntryData data;
+        if (!LoadEntryData(head, data)) {
+            return false;
+        }
+
+        const uint8_t* start = data.span.data();
+        size_t size = data.span.size();
+        return AlignToQfsSignature(start, size) &&
+            QFS::Decompressor::IsQFSCompressed(std::span<const uint8_t>(start, size));
+    }
+
+    void Reader::CountRange(const io::MappedFile::Range& range) const {
+        if (!mStats) {
+            return;
+        }
+        if (range.UsesReadFallback()) {
+            mStats->RecordFallbackRead(range.View().size());
+        }
+        else {
+            mStats->RecordMapped(range.View().size());
+        }
+    }
+
+    const IndexEntry* Reader::FindEntry(const Tgi& tgi) const {
+        const auto position = mTgiIndex.Find(tgi);
+        if (!position) {
+            return nullptr;
+        }
+        return &mIndex[*position];
+    }
+
+    std::vector<const IndexEntry*> Reader::FindEntries(const TgiMask& mask) const {
+        std::vector<uint32_t> positions;
+        mTgiIndex.FindMatching(mask, positions);
+
+        std::vector<const IndexEntry*> matches;
+        matches.reserve(positions.size());
+        for (const auto position : positions) {
+            matches.push_back(&mIndex[position]);
         }
         return matches;
     }
@@ -234,11 +601,13 @@ namespace DBPF {
     }
 
     ParseExpected<FSH::Record> Reader::LoadFSH(const IndexEntry& entry) const {
-        auto payload = ReadEntryData(entry);
-        if (!payload) {
-            return Fail("failed to read data for {}", entry.tgi.ToString());
-        }
-        return FSH::Reader::Parse(std::span<const uint8_t>(payload->data(), payload->size()));
+        return MeasureLoad(mStats.get(), ReaderStats::Parser::kFSH, [&]() -> ParseExpected<FSH::Record> {
+            const auto payload = ReadEntryView(entry);
+            if (!payload) {
+                return Fail("failed to read data for {}", entry.tgi.ToString());
+            }
+            return FSH::Reader::Parse(payload->Data());
+        });
     }
 
     ParseExpected<FSH::Record> Reader::LoadFSH(const Tgi& tgi) const {
@@ -266,11 +635,13 @@ namespace DBPF {
     }
 
     ParseExpected<S3D::Record> Reader::LoadS3D(const IndexEntry& entry) const {
-        auto payload = ReadEntryData(entry);
-        if (!payload) {
-            return Fail("Failed to read data for {}", entry.tgi.ToString());
-        }
-        return S3D::Reader::Parse(std::span<const uint8_t>(payload->data(), payload->size()));
+        return MeasureLoad(mStats.get(), ReaderStats::Parser::kS3D, [&]() -> ParseExpected<S3D::Record> {
+            const auto payload = ReadEntryView(entry);
+            if (!payload) {
+                return Fail("Failed to read data for {}", entry.tgi.ToString());
+            }
+            return S3D::Reader::Parse(payload->Data());
+        });
     }
 
     ParseExpected<S3D::Record> Reader::LoadS3D(const Tgi& tgi) const {
@@ -298,11 +669,13 @@ namespace DBPF {
     }
 
     ParseExpected<Exemplar::Record> Reader::LoadExemplar(const IndexEntry& entry) const {
-        auto payload = ReadEntryData(entry);
-        if (!payload) {
-            return Fail("Failed to read data for {}", entry.tgi.ToString());
-        }
-        return Exemplar::Parse(std::span<const uint8_t>(payload->data(), payload->size()));
+        return MeasureLoad(mStats.get(), ReaderStats::Parser::kExemplar, [&]() -> ParseExpected<Exemplar::Record> {
+            const auto payload = ReadEntryView(entry);
+            if (!payload) {
+                return Fail("Failed to read data for {}", entry.tgi.ToString());
+            }
+            return Exemplar::Parse(payload->Data());
+        });
     }
 
     ParseExpected<Exemplar::Record> Reader::LoadExemplar(const Tgi& tgi) const {
@@ -330,12 +703,13 @@ namespace DBPF {
     }
 
     ParseExpected<LText::Record> Reader::LoadLText(const IndexEntry& entry) const {
-        auto payload = ReadEntryData(entry);
-        if (!payload.has_value()) {
-            return Fail("Failed to read entry data for {}", entry.tgi.ToString());
-        }
-        std::span<const uint8_t> buffer(payload->data(), payload->size());
-        return LText::Parse(buffer);
+        return MeasureLoad(mStats.get(), ReaderStats::Parser::kLText, [&]() -> ParseExpected<LText::Record> {
+            const auto payload = ReadEntryView(entry);
+            if (!payload.has_value()) {
+                return Fail("Failed to read entry data for {}", entry.tgi.ToString());
+            }
+            return LText::Parse(payload->Data());
+        });
     }
 
     ParseExpected<LText::Record> Reader::LoadLText(const Tgi& tgi) const {
@@ -363,12 +737,13 @@ namespace DBPF {
     }
 
     ParseExpected<RUL0::Record> Reader::LoadRUL0(const IndexEntry& entry) const {
-        auto payload = ReadEntryData(entry);
-        if (!payload.has_value()) {
-            return Fail("Failed to read entry data for {}", entry.tgi.ToString());
-        }
-        const std::span<const uint8_t> buffer(payload->data(), payload->size());
-        return RUL0::Parse(buffer);
+        return MeasureLoad(mStats.get(), ReaderStats::Parser::kRUL0, [&]() -> ParseExpected<RUL0::Record> {
+            const auto payload = ReadEntryView(entry);
+            if (!payload.has_value()) {
+                return Fail("Failed to read entry data for {}", entry.tgi.ToString());
+            }
+            return RUL0::Parse(payload->Data());
+        });
     }
 
     ParseExpected<RUL0::Record> Reader::LoadRUL0() const {
@@ -379,12 +754,255 @@ namespace DBPF {
         return LoadRUL0(entry.value());
     }
 
+    std::vector<std::optional<std::vector<uint8_t>>> Reader::ReadEntries(std::span<const IndexEntry* const> entries,
+                                                                         ThreadPool* pool) const {
+        return RunBatch<std::optional<std::vector<uint8_t>>>(entries, pool, [this](const IndexEntry* entry) {
+            return entry ? ReadEntryData(*entry) : std::nullopt;
+        });
+    }
+
+    std::vector<ParseExpected<Exemplar::Record>> Reader::LoadExemplars(std::span<const IndexEntry* const> entries,
+                                                                       ThreadPool* pool) const {
+        return RunBatch<ParseExpected<Exemplar::Record>>(entries, pool,
+            [this](const IndexEntry* entry) -> ParseExpected<Exemplar::Record> {
+                if (!entry) {
+                    return Fail("Null entry in exemplar batch");
+                }
+                return LoadExemplar(*entry);
+            });
+    }
+
+    bool Reader::DecodeEntries(std::span<const IndexEntry* const> entries, const BatchVisitor& visitor,
+                               ThreadPool* pool) const {
+        struct Scratch {
+            std::vector<uint8_t> raw;
+            std::vector<uint8_t> decoded;
+            // Only the slot's own thread touches it, so a plain flag is enough.
+            bool busy = false;
+        };
+        struct SlotLease {
+            Scratch* slot;
+            ~SlotLease() {
+                if (slot) {
+                    slot->busy = false;
+                }
+            }
+        };
+
+        auto& workers = pool ? *pool : ThreadPool::Shared();
+        // One slot per worker plus one for the calling thread, which helps while it waits.
+        std::vector<Scratch> scratch(workers.Size() + 1);
+        const auto caller = std::this_thread::get_id();
+        // Without a whole-file mapping each range would be read into a fresh allocation, so read into scratch.
+        const bool readIntoScratch = mDataSource == DataSource::kMappedFile && !mMappedFile.IsWholeFileMapped();
+        std::atomic<bool> ok = true;
+
+        workers.ParallelFor(entries.size(), [&](const size_t i) {
+            const IndexEntry* entry = entries[i];
+            if (!entry) {
+                ok.store(false, std::memory_order_relaxed);
+                return;
+            }
+
+            // A thread that is not ours only shows up when it helps with another ParallelFor on the same pool. Our
+            // own threads can also re-enter: a visitor that runs a ParallelFor on the pool may pick up a sibling
+            // item while it waits, and that item must not touch the scratch the visitor's payload points into.
+            Scratch local;
+            const auto worker = workers.CurrentWorkerIndex();
+            Scratch* slot = worker ? &scratch[*worker]
+                                   : std::this_thread::get_id() == caller ? &scratch.back() : nullptr;
+            if (slot && slot->busy) {
+                slot = nullptr;
+            }
+            const SlotLease lease{slot};
+            if (slot) {
+                slot->busy = true;
+            }
+            Scratch& buffers = slot ? *slot : local;
+
+            std::span<const uint8_t> raw;
+            EntryData entryData;
+            if (readIntoScratch) {
+                if (buffers.raw.size() < entry->size) {
+                    buffers.raw.resize(entry->size);
+                }
+                raw = std::span<const uint8_t>(buffers.raw.data(), entry->size);
+                if (!mMappedFile.ReadAt(entry->offset, std::span<uint8_t>(buffers.raw.data(), raw.size()))) {
+                    std::println("[DBPF] Failed to read entry {}", entry->tgi.ToString());
+                    if (mStats) {
+                        mStats->RecordReadFailure();
+                    }
+                    ok.store(false, std::memory_order_relaxed);
+                    return;
+                }
+                if (mStats) {
+                    mStats->RecordFallbackRead(raw.size());
+                }
+            }
+            else {
+                if (!LoadEntryData(*entry, entryData)) {
+                    std::println("[DBPF] Invalid bounds for entry {} (offset {}, size {})",
+                                  entry->tgi.ToString(), entry->offset, entry->size);
+                    if (mStats) {
+                        mStats->RecordReadFailure();
+                    }
+                    ok.store(false, std::memory_order_relaxed);
+                    return;
+                }
+                raw = entryData.span;
+            }
+
+            // Size the decode buffer up front when the directory lists the decompressed size.
+            if (entry->decompressedSize && buffers.decoded.size() < *entry->decompressedSize) {
+                buffers.decoded.resize(*entry->decompressedSize);
+            }
+            std::span<const uint8_t> payload;
+            if (!DecodeStreamedPayload(raw, buffers.decoded, payload, mStats.get())) {
+                std::println("[DBPF] Failed to decode entry {}", entry->tgi.ToString());
+                ok.store(false, std::memory_order_relaxed);
+                return;
+            }
+            visitor(i, *entry, payload);
+        });
+        return ok.load();
+    }
+
+    bool Reader::ForEachEntryInFileOrder(const EntryVisitor& visitor, size_t windowBytes) const {
+        constexpr size_t kMinimumWindow = 64 * 1024;
+        windowBytes = std::max(windowBytes, kMinimumWindow);
+
+        std::vector<const IndexEntry*> ordered;
+        ordered.reserve(mIndex.size());
+        for (const auto& entry : mIndex) {
+            ordered.push_back(&entry);
+        }
+        std::ranges::stable_sort(ordered, {}, [](const IndexEntry* entry) { return entry->offset; });
+
+        const bool fromMapping = mDataSource == DataSource::kMappedFile && mMappedFile.IsWholeFileMapped();
+        const bool fromReads = mDataSource == DataSource::kMappedFile && !fromMapping;
+
+        std::vector<uint8_t> window;
+        std::vector<uint8_t> oversized;
+        std::vector<uint8_t> scratch;
+        uint64_t windowStart = 0;
+        size_t windowSize = 0;
+        uint64_t prefetchedUpTo = 0;
+        uint64_t releasedUpTo = 0;
+
+        // Returns the raw bytes of an entry from the sliding window, refilling it when the entry falls outside.
+        auto readThroughWindow = [&](const IndexEntry& entry) -> std::optional<std::span<const uint8_t>> {
+            const uint64_t begin = entry.offset;
+            const uint64_t end = begin + entry.size;
+            if (end > mMappedFile.FileSize()) {
+                return std::nullopt;
+            }
+            if (entry.size > windowBytes) {
+                oversized.resize(entry.size);
+                if (!mMappedFile.ReadAt(begin, oversized)) {
+                    return std::nullopt;
+                }
+                if (mStats) {
+                    mStats->RecordFallbackRead(oversized.size());
+                }
+                return std::span<const uint8_t>(oversized);
+            }
+            if (begin < windowStart || end > windowStart + windowSize) {
+                window.resize(windowBytes);
+                const auto fill = static_cast<size_t>(std::min<uint64_t>(windowBytes, mMappedFile.FileSize() - begin));
+                if (!mMappedFile.ReadAt(begin, std::span<uint8_t>(window.data(), fill))) {
+                    windowSize = 0;
+                    return std::nullopt;
+                }
+                windowStart = begin;
+                windowSize = fill;
+                if (mStats) {
+                    mStats->RecordFallbackRead(fill);
+                }
+                mMappedFile.PrefetchRange(begin + fill, windowBytes);
+            }
+            return std::span<const uint8_t>(window.data() + (begin - windowStart), entry.size);
+        };
+
+        bool allOk = true;
+        for (const auto* entry : ordered) {
+            EntryData entryData;
+            std::optional<std::span<const uint8_t>> raw;
+            if (fromReads) {
+                raw = readThroughWindow(*entry);
+            }
+            else if (LoadEntryData(*entry, entryData)) {
+                raw = entryData.span;
+            }
+
+            std::span<const uint8_t> payload;
+            if (!raw || !DecodeStreamedPayload(*raw, scratch, payload, mStats.get())) {
+                std::println("[DBPF] Failed to stream entry {} (offset {}, size {})",
+                              entry->tgi.ToString(), entry->offset, entry->size);
+                if (!raw && mStats) {
+                    mStats->RecordReadFailure();
+                }
+                allOk = false;
+                continue;
+            }
+
+            if (fromMapping) {
+                const uint64_t end = static_cast<uint64_t>(entry->offset) + entry->size;
+                while (prefetchedUpTo < end + windowBytes && prefetchedUpTo < mMappedFile.FileSize()) {
+                    mMappedFile.PrefetchRange(prefetchedUpTo, windowBytes);
+                    prefetchedUpTo += windowBytes;
+                }
+            }
+
+            if (!visitor(*entry, payload)) {
+                break;
+            }
+
+            if (fromMapping && entry->offset > releasedUpTo + windowBytes) {
+                mMappedFile.ReleaseRange(releasedUpTo, entry->offset - releasedUpTo);
+                releasedUpTo = entry->offset;
+            }
+        }
+        return allOk;
+    }
+
+    void Reader::Prefetch(std::span<const IndexEntry* const> entries) const {
+        if (mDataSource != DataSource::kMappedFile || entries.empty()) {
+            return;
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        ranges.reserve(entries.size());
+        for (const auto* entry : entries) {
+            if (entry && entry->size > 0) {
+                ranges.emplace_back(entry->offset, static_cast<uint64_t>(entry->offset) + entry->size);
+            }
+        }
+        std::ranges::sort(ranges);
+
+        size_t i = 0;
+        while (i < ranges.size()) {
+            const uint64_t begin = ranges[i].first;
+            uint64_t end = ranges[i].second;
+            for (++i; i < ranges.size() && ranges[i].first <= end + kPrefetchMergeGap; ++i) {
+                end = std::max(end, ranges[i].second);
+            }
+            mMappedFile.PrefetchRange(begin, end - begin);
+        }
+    }
+
+    std::future<void> Reader::PrefetchAsync(std::vector<const IndexEntry*> entries, ThreadPool* pool) const {
+        auto task = std::make_shared<std::packaged_task<void()>>([this, entries = std::move(entries)] {
+            Prefetch(entries);
+        });
+        auto future = task->get_future();
+        (pool ? *pool : ThreadPool::Shared()).Submit([task] { (*task)(); });
+        return future;
+    }
+
     bool Reader::ParseBuffer(const std::span<const uint8_t> buffer) {
         mIndex.clear();
-        mTGIIndex.clear();
-        mTypeIndex.clear();
-        mGroupIndex.clear();
-        mInstanceIndex.clear();
+        mTgiIndex.Clear();
+        mHasDirectory = false;
         if (buffer.size() < kHeaderSize) {
             return false;
         }
@@ -403,6 +1021,7 @@ namespace DBPF {
     }
 
     bool Reader::ParseHeader(std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE("dbpf", "ParseHeader");
         if (buffer.size() < kHeaderSize) {
             return false;
         }
@@ -441,6 +1060,7 @@ namespace DBPF {
     }
 
     bool Reader::ParseIndexSpan(std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE("dbpf", "ParseIndexSpan");
         if (buffer.size() < mHeader.indexEntryCount * 20) {
             return false;
         }
@@ -466,29 +1086,21 @@ namespace DBPF {
         }
 
         mIndex = std::move(parsed);
-        mTGIIndex.clear();
-        mTypeIndex.clear();
-        mGroupIndex.clear();
-        mInstanceIndex.clear();
-
-        for (auto& entry : mIndex) {
-            mTGIIndex.emplace(entry.tgi, &entry);
-            mTypeIndex.emplace(entry.tgi.type, &entry);
-            mGroupIndex.emplace(entry.tgi.group, &entry);
-            mInstanceIndex.emplace(entry.tgi.instance, &entry);
-        }
+        mTgiIndex.Build(mIndex);
 
         return true;
     }
 
     bool Reader::ApplyDirectoryMetadata() {
-        const auto dirIt = mTGIIndex.find(kDirectoryTgi);
-        if (dirIt == mTGIIndex.end() || dirIt->second == nullptr) {
+        DBPFKIT_TRACE_SCOPE("dbpf", "ApplyDirectoryMetadata");
+        const auto dirPosition = mTgiIndex.Find(kDirectoryTgi);
+        mHasDirectory = dirPosition.has_value();
+        if (!mHasDirectory) {
             return true;
         }
 
         EntryData directoryData;
-        if (!LoadEntryData(*dirIt->second, directoryData)) {
+        if (!LoadEntryData(mIndex[*dirPosition], directoryData)) {
             return false;
         }
 
@@ -505,9 +1117,8 @@ namespace DBPF {
             tgi.instance = ReadUInt32LE(ptr + 8);
             uint32_t decompressed = ReadUInt32LE(ptr + 12);
 
-            auto it = mTGIIndex.find(tgi);
-            if (it != mTGIIndex.end() && it->second != nullptr) {
-                it->second->decompressedSize = decompressed;
+            if (const auto position = mTgiIndex.Find(tgi)) {
+                mIndex[*position].decompressedSize = decompressed;
             }
 
             ptr += kRecordSize;
@@ -517,14 +1128,13 @@ namespace DBPF {
 
     bool Reader::ParseMappedFile() {
         mIndex.clear();
-        mTGIIndex.clear();
-        mTypeIndex.clear();
-        mGroupIndex.clear();
-        mInstanceIndex.clear();
+        mTgiIndex.Clear();
+        mHasDirectory = false;
         io::MappedFile::Range headerRange;
         if (!mMappedFile.MapRange(0, kHeaderSize, headerRange)) {
             return false;
         }
+        CountRange(headerRange);
         if (!ParseHeader(headerRange.View())) {
             return false;
         }
@@ -535,6 +1145,7 @@ namespace DBPF {
                                   indexRange)) {
             return false;
         }
+        CountRange(indexRange);
         if (!ParseIndexSpan(indexRange.View())) {
             return false;
         }
@@ -550,10 +1161,10 @@ namespace DBPF {
 
         switch (mDataSource) {
         case DataSource::kBuffer: {
-            if (mFileBuffer.empty() || start > mFileBuffer.size() || start + length > mFileBuffer.size()) {
+            if (mBufferView.empty() || start > mBufferView.size() || start + length > mBufferView.size()) {
                 return false;
             }
-            out.span = std::span(mFileBuffer.data() + start, length);
+            out.span = mBufferView.subspan(start, length);
             return true;
         }
         case DataSource::kMappedFile: {
@@ -563,6 +1174,7 @@ namespace DBPF {
             if (!mMappedFile.MapRange(entry.offset, length, out.mappedRange)) {
                 return false;
             }
+            CountRange(out.mappedRange);
             out.span = out.mappedRange.View();
             return out.span.size() == length;
         }
@@ -2,15 +2,21 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <future>
+#include <memory_resource>
 #include <optional>
 #include <span>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
 #include "DBPFStructures.h"
+#include "EntryCache.h"
 #include "MappedFile.h"
 #include "ParseTypes.h"
+#include "ReaderStats.h"
+#include "TgiIndex.h"
 
 namespace FSH { struct Record; }
 namespace S3D { struct Record; }
@@ -19,8 +25,8 @@ namespace LText { struct Record; }
 namespace RUL0 { struct Record; }
 
 namespace DBPF {
-    struct TgiHash;
     struct Tgi;
+    class ThreadPool;
 
     constexpr Tgi kDirectoryTgi{0xE86B1EEF, 0xE86B1EEF, 0x286B1F03};
     constexpr Tgi kRul0Tgi{0x0A5BCF4B, 0xAA5BCF57, 0x10000000};
@@ -39,15 +45,93 @@ namespace DBPF {
         uint32_t holeSize = 0;
     };
 
+    // Payload of an entry returned by Reader::ReadEntryView. Uncompressed payloads borrow directly from the
+    // reader's buffer or mapping and stay valid until the reader is reloaded or destroyed; only QFS-compressed
+    // payloads own a decompressed copy.
+    class EntryView {
+    public:
+        [[nodiscard]] std::span<const uint8_t> Data() const { return mSpan; }
+        [[nodiscard]] size_t Size() const { return mSpan.size(); }
+        [[nodiscard]] bool Empty() const { return mSpan.empty(); }
+        [[nodiscard]] bool IsDecompressed() const { return mDecompressed; }
+
+    private:
+        friend class Reader;
+
+        io::MappedFile::Range mRange;
+        std::vector<uint8_t> mOwned;
+        EntryCache::Buffer mShared;
+        std::span<const uint8_t> mSpan{};
+        bool mDecompressed = false;
+    };
+
+    // Header and index of an archive that were parsed earlier, e.g. read back from an IndexCache.
+    struct PrecomputedIndex {
+        Header header{};
+        std::span<const PackedIndexEntry> entries{};
+        bool hasDirectory = false;
+    };
+
+    // Once LoadFile/LoadBuffer has returned, every const member function may be called concurrently from any
+    // number of threads. Loading a new archive must not overlap with any other call on the same reader.
     class Reader {
     public:
-        bool LoadFile(const std::filesystem::path& path);
+        // Receives each entry's decoded payload; the span is only valid during the call. Return false to stop.
+        using EntryVisitor = std::function<bool(const IndexEntry& entry, std::span<const uint8_t> payload)>;
+        // Receives an entry's position in the batch and its decoded payload. Called concurrently from pool threads;
+        // the span is only valid during the call.
+        using BatchVisitor =
+            std::function<void(size_t index, const IndexEntry& entry, std::span<const uint8_t> payload)>;
+        static constexpr size_t kDefaultStreamWindow = 4 * 1024 * 1024;
+
+        bool LoadFile(const std::filesystem::path& path,
+                      io::MappedFile::MappingMode mode = io::MappedFile::MappingMode::kWholeFile);
+        // Opens the archive but takes its header and index from a previous parse instead of reading them.
+        bool LoadFile(const std::filesystem::path& path, const PrecomputedIndex& index,
+                      io::MappedFile::MappingMode mode = io::MappedFile::MappingMode::kWholeFile);
         bool LoadBuffer(const uint8_t* data, size_t size);
+        // Indexes the caller's bytes in place without copying. They must stay alive and unchanged until the
+        // reader is reloaded or destroyed.
+        bool LoadBorrowedBuffer(std::span<const uint8_t> data);
+        // Indexes in place and keeps the bytes alive by sharing ownership with the caller.
+        bool LoadSharedBuffer(std::shared_ptr<const std::byte[]> data, size_t size);
 
         [[nodiscard]] const Header& GetHeader() const { return mHeader; }
         [[nodiscard]] const std::vector<IndexEntry>& GetIndex() const { return mIndex; }
+        [[nodiscard]] bool HasDirectory() const { return mHasDirectory; }
+        // Keeps up to capacityBytes of decompressed payloads so repeated reads of the same entry skip the QFS
+        // decode; every read path, including the typed loaders, goes through it. 0 disables the cache. Resizing
+        // an enabled cache is thread-safe, but enabling or disabling it must not overlap with other calls.
+        void SetEntryCacheCapacity(size_t capacityBytes);
+        [[nodiscard]] const EntryCache* GetEntryCache() const { return mEntryCache.get(); }
+        // Starts counting I/O, decompression and typed-loader work in a ReaderStats (off by default). The counts
+        // survive reloading the reader. Enabling or disabling must not overlap with other calls; snapshots and
+        // resets through GetStats() may happen at any time.
+        void SetStatsEnabled(bool enabled);
+        // Null while statistics are disabled.
+        [[nodiscard]] ReaderStats* GetStats() const { return mStats.get(); }
         [[nodiscard]] std::optional<std::vector<uint8_t>> ReadEntryData(const IndexEntry& entry) const;
         [[nodiscard]] std::optional<std::vector<uint8_t>> ReadEntryData(const Tgi& tgi) const;
+        [[nodiscard]] std::optional<EntryView> ReadEntryView(const IndexEntry& entry) const;
+        [[nodiscard]] std::optional<EntryView> ReadEntryView(const Tgi& tgi) const;
+        // The payload as a shared immutable buffer, served from the entry cache when one is enabled.
+        [[nodiscard]] EntryCache::Buffer ReadEntryShared(const IndexEntry& entry) const;
+        [[nodiscard]] EntryCache::Buffer ReadEntryShared(const Tgi& tgi) const;
+        [[nodiscard]] std::optional<std::pmr::vector<uint8_t>> ReadEntryData(const IndexEntry& entry,
+                                                                             std::pmr::memory_resource* resource) const;
+        // Writes the entry payload into caller-owned storage and returns the number of bytes written.
+        // Fails if out is smaller than GetPayloadSize(entry).
+        [[nodiscard]] std::optional<size_t> ReadEntryInto(const IndexEntry& entry, std::span<uint8_t> out) const;
+        [[nodiscard]] std::optional<size_t> GetPayloadSize(const IndexEntry& entry) const;
+        // Largest IndexEntry::GetSize(); only an upper bound on payload sizes when directory metadata is present.
+        [[nodiscard]] uint32_t GetLargestEntrySize() const;
+        // Whether the entry holds QFS data. Taken from the directory when the archive has one, otherwise probed
+        // from the first bytes of the payload.
+        [[nodiscard]] bool IsCompressed(const IndexEntry& entry) const;
+        // The index in PackedIndexEntry form, in index order. Fails if an entry is too large to pack. Compression
+        // is recorded from the directory; without one it is left unknown unless probeCompression is set, which
+        // reads the first bytes of every entry.
+        [[nodiscard]] std::optional<std::vector<PackedIndexEntry>> GetPackedIndex(bool probeCompression = false) const;
         [[nodiscard]] const IndexEntry* FindEntry(const Tgi& tgi) const;
         [[nodiscard]] std::optional<IndexEntry> FindFirstEntry(std::string_view label) const;
         [[nodiscard]] std::vector<const IndexEntry*> FindEntries(const TgiMask& mask) const;
@@ -73,6 +157,28 @@ namespace DBPF {
         [[nodiscard]] ParseExpected<RUL0::Record> LoadRUL0(const IndexEntry& entry) const;
         [[nodiscard]] ParseExpected<RUL0::Record> LoadRUL0() const;
 
+        // Batch variants fan out across the pool (ThreadPool::Shared() when null) and return results in input order.
+        [[nodiscard]] std::vector<std::optional<std::vector<uint8_t>>> ReadEntries(
+            std::span<const IndexEntry* const> entries, ThreadPool* pool = nullptr) const;
+        [[nodiscard]] std::vector<ParseExpected<Exemplar::Record>> LoadExemplars(
+            std::span<const IndexEntry* const> entries, ThreadPool* pool = nullptr) const;
+        // Decodes the entries on the pool without allocating per entry: every worker reuses its own scratch
+        // buffers, grown to the largest entry it has seen. Returns false if any entry could not be read or
+        // decoded; the visitor is not called for those.
+        bool DecodeEntries(std::span<const IndexEntry* const> entries, const BatchVisitor& visitor,
+                           ThreadPool* pool = nullptr) const;
+
+        // Walks all entries sorted by file offset so a full scan is sequential I/O. Reads go through a bounded
+        // window (entries larger than the window are read on their own), keeping memory use independent of the
+        // archive size. Returns false if any entry could not be read or decoded.
+        bool ForEachEntryInFileOrder(const EntryVisitor& visitor, size_t windowBytes = kDefaultStreamWindow) const;
+
+        // Warms the pages backing the given entries. Nearby entries are coalesced into one readahead request.
+        void Prefetch(std::span<const IndexEntry* const> entries) const;
+        // Runs Prefetch on the pool so it can proceed ahead of the consumer; the reader must outlive the future.
+        [[nodiscard]] std::future<void> PrefetchAsync(std::vector<const IndexEntry*> entries,
+                                                      ThreadPool* pool = nullptr) const;
+
     private:
         enum class DataSource {
             kNone,
@@ -85,6 +191,8 @@ namespace DBPF {
             io::MappedFile::Range mappedRange{};
         };
 
+        void ResetSource();
+        bool AdoptBuffer(std::span<const uint8_t> buffer);
         bool ParseBuffer(std::span<const uint8_t> buffer);
         bool ParseHeader(std::span<const uint8_t> buffer);
         bool ParseIndex(std::span<const uint8_t> buffer);
@@ -92,16 +200,24 @@ namespace DBPF {
         bool ApplyDirectoryMetadata();
         bool ParseMappedFile();
         bool LoadEntryData(const IndexEntry& entry, EntryData& out) const;
+        bool LoadEntryPayload(const IndexEntry& entry, EntryData& out) const;
+        bool ProbeCompressed(const IndexEntry& entry) const;
+        void CountRange(const io::MappedFile::Range& range) const;
+        // Only the first entry for a TGI is cached, since the cache is keyed by TGI alone.
+        bool IsCacheable(const IndexEntry& entry) const;
+        std::optional<EntryView> FindCachedView(const IndexEntry& entry) const;
 
         std::vector<uint8_t> mFileBuffer;
+        std::shared_ptr<const std::byte[]> mSharedBuffer;
+        std::span<const uint8_t> mBufferView{};
         io::MappedFile mMappedFile;
         Header mHeader{};
         std::vector<IndexEntry> mIndex;
 
-        std::unordered_map<Tgi, IndexEntry*, TgiHash> mTGIIndex;
-        std::unordered_multimap<uint32_t, IndexEntry*> mTypeIndex;
-        std::unordered_multimap<uint32_t, IndexEntry*> mGroupIndex;
-        std::unordered_multimap<uint32_t, IndexEntry*> mInstanceIndex;
+        TgiIndex mTgiIndex;
+        std::unique_ptr<EntryCache> mEntryCache;
+        std::unique_ptr<ReaderStats> mStats;
+        bool mHasDirectory = false;
         DataSource mDataSource = DataSource::kNone;
     };
 
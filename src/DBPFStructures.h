@@ -20,6 +20,66 @@ namespace DBPF {
         }
     };
 
+    // 24-byte export form of IndexEntry, used to persist indexes (e.g. in an IndexCache); the reader itself keeps
+    // IndexEntry in memory. The top three bits of the stored size hold the flags, so entries of 512 MiB or more
+    // cannot be packed. Whether an entry is compressed is only recorded when it was known at packing time.
+    class PackedIndexEntry {
+    public:
+        static constexpr uint32_t kHasDecompressedSize = 1u << 31;
+        static constexpr uint32_t kCompressed = 1u << 30;
+        static constexpr uint32_t kCompressionKnown = 1u << 29;
+        static constexpr uint32_t kSizeMask = kCompressionKnown - 1;
+
+        [[nodiscard]] static std::optional<PackedIndexEntry> Pack(const IndexEntry& entry,
+                                                                  const std::optional<bool> compressed) {
+            if (entry.size > kSizeMask) {
+                return std::nullopt;
+            }
+            PackedIndexEntry packed;
+            packed.tgi = entry.tgi;
+            packed.offset = entry.offset;
+            packed.mSizeAndFlags = entry.size;
+            if (compressed.has_value()) {
+                packed.mSizeAndFlags |= kCompressionKnown | (*compressed ? kCompressed : 0);
+            }
+            if (entry.decompressedSize.has_value()) {
+                packed.mSizeAndFlags |= kHasDecompressedSize;
+                packed.mDecompressedSize = *entry.decompressedSize;
+            }
+            return packed;
+        }
+
+        [[nodiscard]] IndexEntry Unpack() const {
+            IndexEntry entry;
+            entry.tgi = tgi;
+            entry.offset = offset;
+            entry.size = Size();
+            entry.decompressedSize = DecompressedSize();
+            return entry;
+        }
+
+        [[nodiscard]] uint32_t Size() const { return mSizeAndFlags & kSizeMask; }
+        [[nodiscard]] bool IsCompressionKnown() const { return (mSizeAndFlags & kCompressionKnown) != 0; }
+        // False when the entry is uncompressed or its compression was not known when it was packed.
+        [[nodiscard]] bool IsCompressed() const { return (mSizeAndFlags & kCompressed) != 0; }
+        [[nodiscard]] bool HasDecompressedSize() const { return (mSizeAndFlags & kHasDecompressedSize) != 0; }
+        [[nodiscard]] std::optional<uint32_t> DecompressedSize() const {
+            if (!HasDecompressedSize()) {
+                return std::nullopt;
+            }
+            return mDecompressedSize;
+        }
+        [[nodiscard]] uint32_t GetSize() const { return HasDecompressedSize() ? mDecompressedSize : Size(); }
+
+        Tgi tgi;
+        uint32_t offset = 0;
+
+    private:
+        uint32_t mSizeAndFlags = 0;
+        uint32_t mDecompressedSize = 0;
+    };
+    static_assert(sizeof(PackedIndexEntry) == 24);
+
     struct Entry {
         IndexEntry index;
         std::vector<uint8_t> data;
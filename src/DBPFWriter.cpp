@@ -0,0 +1,261 @@
+#include "DBPFWriter.h"
+
+#include <array>
+#include <ctime>
+#include <limits>
+#include <print>
+
+#include "DBPFReader.h"
+#include "QFSCompressor.h"
+#include "ThreadPool.h"
+
+namespace {
+
+    constexpr size_t kHeaderSize = 0x60;
+    constexpr uint32_t kIndexType = 7;
+    constexpr size_t kIndexRecordSize = 20;
+    constexpr size_t kDirectoryRecordSize = 16;
+    // Compressed entries start with their total stored size, followed by the QFS stream.
+    constexpr size_t kCompressedPrefixSize = 4;
+
+    void AppendUInt32LE(std::vector<uint8_t>& out, const uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 24));
+    }
+
+    void StoreUInt32LE(uint8_t* out, const uint32_t value) {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out[2] = static_cast<uint8_t>(value >> 16);
+        out[3] = static_cast<uint8_t>(value >> 24);
+    }
+
+    // Replaces data with its stored form when compression pays off; returns whether it did.
+    bool CompressEntry(std::vector<uint8_t>& data, const QFS::Compressor::Level level) {
+        if (data.size() > QFS::Compressor::kMaxInputSize) {
+            return false;
+        }
+        auto compressed = QFS::Compressor::Compress(data, level);
+        if (!compressed.has_value() || compressed->size() + kCompressedPrefixSize >= data.size()) {
+            return false;
+        }
+
+        std::vector<uint8_t> stored;
+        stored.reserve(compressed->size() + kCompressedPrefixSize);
+        AppendUInt32LE(stored, static_cast<uint32_t>(compressed->size() + kCompressedPrefixSize));
+        stored.insert(stored.end(), compressed->begin(), compressed->end());
+        data = std::move(stored);
+        return true;
+    }
+
+} // namespace
+
+namespace DBPF {
+
+    Writer::Writer(ThreadPool* pool, const size_t maxInFlightBytes)
+        : mPool(pool)
+        , mMaxInFlightBytes(maxInFlightBytes) {}
+
+    Writer::~Writer() {
+        Abandon();
+    }
+
+    bool Writer::Open(const std::filesystem::path& path) {
+        Abandon();
+        mOut.open(path, std::ios::binary | std::ios::trunc);
+        if (!mOut) {
+            std::println("[DBPF] Failed to open {} for writing", path.string());
+            return false;
+        }
+
+        mPath = path;
+        mPosition = 0;
+        mFailed = false;
+        mIndex.clear();
+        mDirectory.clear();
+
+        // The header is rewritten by Finish once the index location is known.
+        const std::array<uint8_t, kHeaderSize> placeholder{};
+        return WriteBytes(placeholder);
+    }
+
+    bool Writer::Add(const Tgi& tgi, std::span<const uint8_t> data, const bool compress) {
+        return Add(tgi, std::vector<uint8_t>(data.begin(), data.end()), compress);
+    }
+
+    bool Writer::Add(const Tgi& tgi, std::vector<uint8_t> data, const bool compress) {
+        if (!IsOpen() || mFailed) {
+            return false;
+        }
+        if (tgi == kDirectoryTgi) {
+            std::println("[DBPF] The directory entry is generated by the writer and cannot be added");
+            return false;
+        }
+        if (data.size() > std::numeric_limits<uint32_t>::max()) {
+            std::println("[DBPF] Entry {} is too large for a DBPF archive", tgi.ToString());
+            return false;
+        }
+
+        auto entry = std::make_unique<PendingEntry>();
+        entry->tgi = tgi;
+        entry->decompressedSize = static_cast<uint32_t>(data.size());
+        entry->data = std::move(data);
+        mInFlightBytes += entry->data.size();
+
+        if (compress) {
+            auto task = std::make_shared<std::packaged_task<void()>>([pending = entry.get(), level = mLevel] {
+                pending->compressed = CompressEntry(pending->data, level);
+            });
+            entry->ready = task->get_future();
+            auto& workers = mPool ? *mPool : ThreadPool::Shared();
+            workers.Submit([task] { (*task)(); });
+        }
+        mInFlight.push_back(std::move(entry));
+
+        while (mInFlightBytes > mMaxInFlightBytes && !mInFlight.empty()) {
+            if (!WriteOldest()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Writer::Finish() {
+        if (!IsOpen()) {
+            return false;
+        }
+        // An entry was dropped, so the archive would be missing it.
+        if (mFailed) {
+            std::println("[DBPF] Not finishing {} after an earlier write failure", mPath.string());
+            Abandon();
+            return false;
+        }
+        while (!mInFlight.empty()) {
+            if (!WriteOldest()) {
+                Abandon();
+                return false;
+            }
+        }
+
+        if (mWriteDirectory && !mDirectory.empty()) {
+            std::vector<uint8_t> directory;
+            directory.reserve(mDirectory.size() * kDirectoryRecordSize);
+            for (const auto& record : mDirectory) {
+                AppendUInt32LE(directory, record.tgi.type);
+                AppendUInt32LE(directory, record.tgi.group);
+                AppendUInt32LE(directory, record.tgi.instance);
+                AppendUInt32LE(directory, record.decompressedSize);
+            }
+            IndexEntry entry;
+            entry.tgi = kDirectoryTgi;
+            entry.offset = static_cast<uint32_t>(mPosition);
+            entry.size = static_cast<uint32_t>(directory.size());
+            if (!CheckOffsetLimit(directory.size()) || !WriteBytes(directory)) {
+                Abandon();
+                return false;
+            }
+            mIndex.push_back(entry);
+        }
+
+        const uint64_t indexOffset = mPosition;
+        std::vector<uint8_t> index;
+        index.reserve(mIndex.size() * kIndexRecordSize);
+        for (const auto& entry : mIndex) {
+            AppendUInt32LE(index, entry.tgi.type);
+            AppendUInt32LE(index, entry.tgi.group);
+            AppendUInt32LE(index, entry.tgi.instance);
+            AppendUInt32LE(index, entry.offset);
+            AppendUInt32LE(index, entry.size);
+        }
+        if (!CheckOffsetLimit(index.size()) || !WriteBytes(index)) {
+            Abandon();
+            return false;
+        }
+
+        const auto now = mTimestamp.value_or(static_cast<uint32_t>(std::time(nullptr)));
+        std::array<uint8_t, kHeaderSize> header{};
+        header[0] = 'D';
+        header[1] = 'B';
+        header[2] = 'P';
+        header[3] = 'F';
+        StoreUInt32LE(header.data() + 4, 1);
+        StoreUInt32LE(header.data() + 8, 0);
+        StoreUInt32LE(header.data() + 24, now);
+        StoreUInt32LE(header.data() + 28, now);
+        StoreUInt32LE(header.data() + 32, kIndexType);
+        StoreUInt32LE(header.data() + 36, static_cast<uint32_t>(mIndex.size()));
+        StoreUInt32LE(header.data() + 40, static_cast<uint32_t>(indexOffset));
+        StoreUInt32LE(header.data() + 44, static_cast<uint32_t>(index.size()));
+
+        mOut.seekp(0);
+        mOut.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        mOut.close();
+        if (!mOut) {
+            std::println("[DBPF] Failed to finish {}", mPath.string());
+            return false;
+        }
+        mIndex.clear();
+        mDirectory.clear();
+        return true;
+    }
+
+    bool Writer::WriteOldest() {
+        auto entry = std::move(mInFlight.front());
+        mInFlight.pop_front();
+        if (entry->ready.valid()) {
+            entry->ready.get();
+        }
+        mInFlightBytes -= entry->decompressedSize;
+
+        IndexEntry indexEntry;
+        indexEntry.tgi = entry->tgi;
+        indexEntry.offset = static_cast<uint32_t>(mPosition);
+        indexEntry.size = static_cast<uint32_t>(entry->data.size());
+        if (!CheckOffsetLimit(entry->data.size()) || !WriteBytes(entry->data)) {
+            return false;
+        }
+
+        mIndex.push_back(indexEntry);
+        if (entry->compressed) {
+            mDirectory.push_back(DirectoryRecord{entry->tgi, entry->decompressedSize});
+        }
+        return true;
+    }
+
+    bool Writer::CheckOffsetLimit(const size_t bytes) {
+        if (mPosition + bytes > std::numeric_limits<uint32_t>::max()) {
+            std::println("[DBPF] {} would exceed the 4 GiB DBPF offset limit", mPath.string());
+            mFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool Writer::WriteBytes(std::span<const uint8_t> bytes) {
+        mOut.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!mOut) {
+            std::println("[DBPF] Failed to write {}", mPath.string());
+            mFailed = true;
+            return false;
+        }
+        mPosition += bytes.size();
+        return true;
+    }
+
+    void Writer::Abandon() {
+        // Compression tasks point at their pending entries, so they have to finish before the entries go away.
+        for (auto& entry : mInFlight) {
+            if (entry->ready.valid()) {
+                entry->ready.wait();
+            }
+        }
+        mInFlight.clear();
+        mInFlightBytes = 0;
+        if (mOut.is_open()) {
+            mOut.close();
+        }
+    }
+
+} // namespace DBPF
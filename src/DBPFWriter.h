@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "DBPFStructures.h"
+#include "QFSCompressor.h"
+
+namespace DBPF {
+
+    class ThreadPool;
+
+    // Streams a DBPF 1.0 archive with a type-7 index to disk. Entries marked for compression are QFS-compressed
+    // on the pool as soon as they are added while earlier entries are written in order, so at most
+    // maxInFlightBytes of input are held at once. Finish appends the directory record for the compressed entries
+    // and the index, then fills in the header. Add and Finish must not be called from a task running on the
+    // same pool.
+    class Writer {
+    public:
+        static constexpr size_t kDefaultInFlightBytes = 64 * 1024 * 1024;
+
+        explicit Writer(ThreadPool* pool = nullptr, size_t maxInFlightBytes = kDefaultInFlightBytes);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer();
+
+        bool Open(const std::filesystem::path& path);
+        [[nodiscard]] bool IsOpen() const { return mOut.is_open(); }
+        // Applies to entries added afterwards.
+        void SetCompressionLevel(QFS::Compressor::Level level) { mLevel = level; }
+        // Without the directory record, readers have to probe each entry for the QFS signature instead.
+        void SetDirectoryEnabled(bool enabled) { mWriteDirectory = enabled; }
+        // Fixes the header's creation and modification dates, e.g. for reproducible output. Defaults to now.
+        void SetTimestamp(uint32_t seconds) { mTimestamp = seconds; }
+
+        // Entries that do not shrink, or are too large for QFS, are stored uncompressed. The directory entry is
+        // generated and cannot be added.
+        bool Add(const Tgi& tgi, std::vector<uint8_t> data, bool compress = false);
+        bool Add(const Tgi& tgi, std::span<const uint8_t> data, bool compress = false);
+
+        bool Finish();
+
+    private:
+        struct PendingEntry {
+            Tgi tgi;
+            std::vector<uint8_t> data;
+            bool compressed = false;
+            uint32_t decompressedSize = 0;
+            std::future<void> ready;
+        };
+
+        struct DirectoryRecord {
+            Tgi tgi;
+            uint32_t decompressedSize = 0;
+        };
+
+        bool WriteOldest();
+        // DBPF offsets and sizes are 32-bit; fails the writer if bytes more would not fit.
+        bool CheckOffsetLimit(size_t bytes);
+        bool WriteBytes(std::span<const uint8_t> bytes);
+        void Abandon();
+
+        ThreadPool* mPool = nullptr;
+        size_t mMaxInFlightBytes = kDefaultInFlightBytes;
+        QFS::Compressor::Level mLevel = QFS::Compressor::Level::kDefault;
+        bool mWriteDirectory = true;
+        std::optional<uint32_t> mTimestamp;
+        std::ofstream mOut;
+        std::filesystem::path mPath;
+        uint64_t mPosition = 0;
+        bool mFailed = false;
+        std::deque<std::unique_ptr<PendingEntry>> mInFlight;
+        size_t mInFlightBytes = 0;
+        std::vector<IndexEntry> mIndex;
+        std::vector<DirectoryRecord> mDirectory;
+    };
+
+} // namespace DBPF
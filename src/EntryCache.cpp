@@ -0,0 +1,90 @@
+#include "EntryCache.h"
+
+#include <iterator>
+
+namespace DBPF {
+
+    EntryCache::EntryCache(const size_t capacityBytes)
+        : mCapacity(capacityBytes) {}
+
+    EntryCache::Buffer EntryCache::Find(const Tgi& tgi) {
+        std::lock_guard lock(mMutex);
+        const auto it = mNodes.find(tgi);
+        if (it == mNodes.end()) {
+            ++mMisses;
+            return nullptr;
+        }
+        ++mHits;
+        mLru.splice(mLru.begin(), mLru, it->second);
+        return it->second->buffer;
+    }
+
+    EntryCache::Buffer EntryCache::Insert(const Tgi& tgi, std::vector<uint8_t> data) {
+        auto buffer = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+        const size_t size = buffer->size();
+
+        std::lock_guard lock(mMutex);
+        if (const auto it = mNodes.find(tgi); it != mNodes.end()) {
+            EraseNode(it->second);
+        }
+        if (size > mCapacity) {
+            return buffer;
+        }
+        EvictToFit(mCapacity - size);
+        mLru.push_front(Node{tgi, buffer});
+        mNodes.emplace(tgi, mLru.begin());
+        mBytes += size;
+        return buffer;
+    }
+
+    void EntryCache::Erase(const Tgi& tgi) {
+        std::lock_guard lock(mMutex);
+        if (const auto it = mNodes.find(tgi); it != mNodes.end()) {
+            EraseNode(it->second);
+        }
+    }
+
+    void EntryCache::Clear() {
+        std::lock_guard lock(mMutex);
+        mLru.clear();
+        mNodes.clear();
+        mBytes = 0;
+    }
+
+    void EntryCache::SetCapacity(const size_t capacityBytes) {
+        std::lock_guard lock(mMutex);
+        mCapacity = capacityBytes;
+        EvictToFit(mCapacity);
+    }
+
+    size_t EntryCache::Capacity() const {
+        std::lock_guard lock(mMutex);
+        return mCapacity;
+    }
+
+    EntryCache::Stats EntryCache::GetStats() const {
+        std::lock_guard lock(mMutex);
+        return Stats{mHits, mMisses, mEvictions, mNodes.size(), mBytes, mCapacity};
+    }
+
+    void EntryCache::ResetStats() {
+        std::lock_guard lock(mMutex);
+        mHits = 0;
+        mMisses = 0;
+        mEvictions = 0;
+    }
+
+    void EntryCache::EraseNode(const std::list<Node>::iterator node) {
+        mBytes -= node->buffer->size();
+        mNodes.erase(node->tgi);
+        mLru.erase(node);
+    }
+
+    void EntryCache::EvictToFit(const size_t budget) {
+        while (mBytes > budget && !mLru.empty()) {
+            EraseNode(std::prev(mLru.end()));
+            ++mEvictions;
+        }
+    }
+
+} // namespace DBPF
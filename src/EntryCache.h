@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "TGI.h"
+
+namespace DBPF {
+
+    // Thread-safe cache of decoded entry payloads keyed by TGI. Holds at most the configured number of payload
+    // bytes and evicts the least recently used payloads first. Buffers are shared and immutable, so a payload
+    // that gets evicted stays alive for as long as a caller still holds it.
+    class EntryCache {
+    public:
+        using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+        struct Stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            size_t entryCount = 0;
+            size_t bytes = 0;
+            size_t capacityBytes = 0;
+        };
+
+        explicit EntryCache(size_t capacityBytes);
+        EntryCache(const EntryCache&) = delete;
+        EntryCache& operator=(const EntryCache&) = delete;
+
+        // Returns the cached payload and marks it most recently used, or null on a miss.
+        [[nodiscard]] Buffer Find(const Tgi& tgi);
+        // Stores the payload, replacing any previous one for the TGI, and returns the shared buffer. Payloads
+        // larger than the whole budget are returned without being kept.
+        Buffer Insert(const Tgi& tgi, std::vector<uint8_t> data);
+        void Erase(const Tgi& tgi);
+        void Clear();
+
+        // Shrinking the budget evicts immediately.
+        void SetCapacity(size_t capacityBytes);
+        [[nodiscard]] size_t Capacity() const;
+        [[nodiscard]] Stats GetStats() const;
+        void ResetStats();
+
+    private:
+        struct Node {
+            Tgi tgi;
+            Buffer buffer;
+        };
+
+        void EraseNode(std::list<Node>::iterator node);
+        void EvictToFit(size_t budget);
+
+        mutable std::mutex mMutex;
+        // Most recently used first.
+        std::list<Node> mLru;
+        std::unordered_map<Tgi, std::list<Node>::iterator, TgiHash> mNodes;
+        size_t mCapacity = 0;
+        size_t mBytes = 0;
+        uint64_t mHits = 0;
+        uint64_t mMisses = 0;
+        uint64_t mEvictions = 0;
+    };
+
+} // namespace DBPF
@@ -1,5 +1,6 @@
 #include "ExemplarReader.h"
 
+#include <algorithm>
 #include <array>
 #include <cctype>
 #include <charconv>
@@ -10,6 +11,7 @@
 #include <string_view>
 
 #include "SafeSpanReader.h"
+#include "Trace.h"
 
 namespace {
 
@@ -228,6 +230,102 @@ namespace {
         return Fail(std::format("Unsupported property key type: {}", *keyType));
     }
 
+    size_t ValueSize(const Exemplar::ValueType type) {
+        switch (type) {
+            case Exemplar::ValueType::UInt8:
+            case Exemplar::ValueType::Bool:
+            case Exemplar::ValueType::String: return 1;
+            case Exemplar::ValueType::UInt16: return 2;
+            case Exemplar::ValueType::UInt32:
+            case Exemplar::ValueType::SInt32:
+            case Exemplar::ValueType::Float32: return 4;
+            case Exemplar::ValueType::SInt64: return 8;
+        }
+        return 0;
+    }
+
+    // Mirrors ParseBinaryProperty, but only records where the values are.
+    ParseExpected<Exemplar::ExemplarView::PropertyInfo> ScanBinaryProperty(DBPF::SafeSpanReader& reader) {
+        Exemplar::ExemplarView::PropertyInfo property{};
+
+        auto id = reader.ReadLE<uint32_t>();
+        if (!id) return std::unexpected(id.error());
+        property.id = *id;
+
+        auto rawValueType = reader.ReadLE<uint16_t>();
+        if (!rawValueType) return std::unexpected(rawValueType.error());
+
+        auto type = ToValueType(*rawValueType);
+        if (!type) {
+            return Fail("Unsupported property value type");
+        }
+        property.type = *type;
+        const bool isString = property.type == Exemplar::ValueType::String;
+
+        auto keyType = reader.ReadLE<uint16_t>();
+        if (!keyType) return std::unexpected(keyType.error());
+
+        size_t size = 0;
+        if (*keyType == 0x0000) {
+            auto lengthOrFlag = reader.ReadLE<uint8_t>();
+            if (!lengthOrFlag) return std::unexpected(lengthOrFlag.error());
+            property.count = 1;
+            size = isString ? *lengthOrFlag : ValueSize(property.type);
+        }
+        else if (*keyType == 0x0080) {
+            auto skip = reader.Skip(1); // skip unused flag
+            if (!skip) return std::unexpected(skip.error());
+
+            auto repetitions = reader.ReadLE<uint32_t>();
+            if (!repetitions) return std::unexpected(repetitions.error());
+
+            // A string "list" is a single string of that many characters.
+            property.isList = !isString;
+            property.count = isString ? 1 : *repetitions;
+            size = static_cast<size_t>(*repetitions) * ValueSize(property.type);
+        }
+        else if (*keyType == 0x0081) {
+            auto skip = reader.Skip(1); // skip unused flag
+            if (!skip) return std::unexpected(skip.error());
+
+            auto totalLength = reader.ReadLE<uint32_t>();
+            if (!totalLength) return std::unexpected(totalLength.error());
+
+            auto entryCount = reader.ReadLE<uint32_t>();
+            if (!entryCount) return std::unexpected(entryCount.error());
+
+            auto arrayData = reader.PeekBytes(*totalLength);
+            if (!arrayData) return std::unexpected(arrayData.error());
+
+            // Validated once here so GetString can walk the length table without checks.
+            const size_t offsetTableSize = static_cast<size_t>(*entryCount) * sizeof(uint32_t);
+            if (offsetTableSize > arrayData->size()) {
+                return Fail("String-array offset table exceeds buffer bounds");
+            }
+            DBPF::SafeSpanReader lengths(arrayData->first(offsetTableSize));
+            size_t stringBytes = 0;
+            for (uint32_t i = 0; i < *entryCount; ++i) {
+                stringBytes += *lengths.ReadLE<uint32_t>();
+            }
+            if (stringBytes > arrayData->size() - offsetTableSize) {
+                return Fail("String-array entry exceeds buffer bounds");
+            }
+
+            property.isList = true;
+            property.count = *entryCount;
+            size = *totalLength;
+        }
+        else {
+            return Fail(std::format("Unsupported property key type: {}", *keyType));
+        }
+
+        property.offset = static_cast<uint32_t>(reader.Offset());
+        property.size = static_cast<uint32_t>(size);
+        auto skipValues = reader.Skip(size);
+        if (!skipValues) return std::unexpected(skipValues.error());
+        return property;
+    }
+
     struct TextCursor {
         const char* ptr = nullptr;
         const char* end = nullptr;
@@ -825,6 +923,7 @@ namespace {
 namespace Exemplar {
 
     ParseExpected<Record> Parse(const std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE_BYTES("parse", "Exemplar::Parse", buffer.size());
         if (buffer.size() < kHeaderSize) {
             return Fail("Buffer too small");
         }
@@ -849,4 +948,95 @@ namespace Exemplar {
         return ParseBinaryExemplar(buffer, info);
     }
 
+    ParseExpected<ExemplarView> ExemplarView::Parse(const std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE_BYTES("parse", "ExemplarView::Parse", buffer.size());
+        if (buffer.size() < kHeaderSize) {
+            return Fail("Buffer too small");
+        }
+
+        auto infoExpected = ParseSignature(buffer.data(), buffer.size());
+        if (!infoExpected.has_value()) {
+            return Fail(std::format("Invalid exemplar signature: {}", infoExpected.error().message));
+        }
+        const auto& info = infoExpected.value();
+
+        if (!info.isValid) {
+            return Fail(("Invalid exemplar signature: " + info.label));
+        }
+        if (info.isText) {
+            return Fail("ExemplarView only reads binary exemplars");
+        }
+
+        ExemplarView view;
+        view.mBuffer = buffer;
+        view.mIsCohort = info.isCohort;
+
+        DBPF::SafeSpanReader reader(buffer);
+        auto skipSignature = reader.Skip(8);
+        if (!skipSignature) return std::unexpected(skipSignature.error());
+
+        auto parentType = reader.ReadLE<uint32_t>();
+        if (!parentType) return std::unexpected(parentType.error());
+        view.mParent.type = *parentType;
+
+        auto parentGroup = reader.ReadLE<uint32_t>();
+        if (!parentGroup) return std::unexpected(parentGroup.error());
+        view.mParent.group = *parentGroup;
+
+        auto parentInstance = reader.ReadLE<uint32_t>();
+        if (!parentInstance) return std::unexpected(parentInstance.error());
+        view.mParent.instance = *parentInstance;
+
+        auto propertyCount = reader.ReadLE<uint32_t>();
+        if (!propertyCount) return std::unexpected(propertyCount.error());
+
+        // Every property takes at least 9 bytes, which bounds the reservation for a corrupt count.
+        view.mProperties.reserve(std::min<size_t>(*propertyCount, reader.Remaining() / 9));
+
+        for (uint32_t i = 0; i < *propertyCount; ++i) {
+            auto propertyExpected = ScanBinaryProperty(reader);
+            if (!propertyExpected.has_value()) {
+                return Fail(std::format("Failed to parse property {}: {}", i, propertyExpected.error().message));
+            }
+            view.mProperties.push_back(*propertyExpected);
+        }
+
+        return view;
+    }
+
+    const ExemplarView::PropertyInfo* ExemplarView::Find(const uint32_t id) const {
+        for (const auto& property : mProperties) {
+            if (property.id == id) {
+                return &property;
+            }
+        }
+        return nullptr;
+    }
+
+    std::optional<std::string_view> ExemplarView::GetString(const uint32_t id, const size_t index) const {
+        const PropertyInfo* property = Find(id);
+        if (!property) {
+            return std::nullopt;
+        }
+        return GetString(*property, index);
+    }
+
+    std::optional<std::string_view> ExemplarView::GetString(const PropertyInfo& property, const size_t index) const {
+        if (property.type != ValueType::String || index >= property.count) {
+            return std::nullopt;
+        }
+        const auto values = mBuffer.subspan(property.offset, property.size);
+        if (!property.isList) {
+            return std::string_view(reinterpret_cast<const char*>(values.data()), values.size());
+        }
+
+        // String array: a table of lengths followed by the strings back to back.
+        const PackedValues<uint32_t> lengths(values.first(static_cast<size_t>(property.count) * sizeof(uint32_t)));
+        size_t offset = lengths.Bytes().size();
+        for (size_t i = 0; i < index; ++i) {
+            offset += lengths[i];
+        }
+        return std::string_view(reinterpret_cast<const char*>(values.data() + offset), lengths[index]);
+    }
+
 } // namespace Exemplar
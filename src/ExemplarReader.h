@@ -1,6 +1,13 @@
 #pragma once
 
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <optional>
 #include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include "ExemplarStructures.h"
 #include "ParseTypes.h"
@@ -9,4 +16,168 @@ namespace Exemplar {
 
     [[nodiscard]] ParseExpected<Record> Parse(std::span<const uint8_t> buffer);
 
+    // Numeric values as they are stored in a binary exemplar. The bytes are little-endian and unaligned, so
+    // elements are copied out on access instead of being exposed as a std::span<const T>.
+    template <typename T>
+    class PackedValues {
+    public:
+        class Iterator {
+        public:
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            explicit Iterator(const uint8_t* data) : mData(data) {}
+
+            T operator*() const { return Load(mData); }
+            Iterator& operator++() {
+                mData += sizeof(T);
+                return *this;
+            }
+            Iterator operator++(int) {
+                auto previous = *this;
+                ++*this;
+                return previous;
+            }
+            bool operator==(const Iterator&) const = default;
+
+        private:
+            const uint8_t* mData = nullptr;
+        };
+
+        PackedValues() = default;
+        explicit PackedValues(const std::span<const uint8_t> bytes) : mBytes(bytes) {}
+
+        [[nodiscard]] size_t Size() const { return mBytes.size() / sizeof(T); }
+        [[nodiscard]] bool Empty() const { return mBytes.empty(); }
+        [[nodiscard]] std::span<const uint8_t> Bytes() const { return mBytes; }
+        [[nodiscard]] T operator[](const size_t index) const { return Load(mBytes.data() + index * sizeof(T)); }
+        [[nodiscard]] Iterator begin() const { return Iterator(mBytes.data()); }
+        [[nodiscard]] Iterator end() const { return Iterator(mBytes.data() + Size() * sizeof(T)); }
+        [[nodiscard]] std::vector<T> ToVector() const { return std::vector<T>(begin(), end()); }
+
+    private:
+        static T Load(const uint8_t* data) {
+            if constexpr (std::is_same_v<T, bool>) {
+                return *data != 0;
+            }
+            else if constexpr (std::is_same_v<T, float>) {
+                uint32_t bits;
+                std::memcpy(&bits, data, sizeof(bits));
+                if constexpr (std::endian::native == std::endian::big) {
+                    bits = std::byteswap(bits);
+                }
+                return std::bit_cast<float>(bits);
+            }
+            else {
+                T value;
+                std::memcpy(&value, data, sizeof(T));
+                if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+                    value = std::byteswap(value);
+                }
+                return value;
+            }
+        }
+
+        std::span<const uint8_t> mBytes;
+    };
+
+    // A binary exemplar read in place. Parse walks the buffer once to record where each property's values are,
+    // and values are only decoded when asked for, so looking up a few properties allocates nothing beyond the
+    // property table. The view borrows the buffer, which must outlive it. Text exemplars are rejected; use
+    // Exemplar::Parse for those.
+    class ExemplarView {
+    public:
+        struct PropertyInfo {
+            uint32_t id = 0;
+            ValueType type = ValueType::UInt32;
+            // Same meaning as Property::isList; a string property is a list only when it is a string array.
+            bool isList = false;
+            // Number of values, or of strings for a string property.
+            uint32_t count = 0;
+            // Byte range of the values in the buffer; for a string array it starts at the length table.
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        [[nodiscard]] static ParseExpected<ExemplarView> Parse(std::span<const uint8_t> buffer);
+
+        [[nodiscard]] const DBPF::Tgi& Parent() const { return mParent; }
+        [[nodiscard]] bool IsCohort() const { return mIsCohort; }
+        [[nodiscard]] std::span<const PropertyInfo> Properties() const { return mProperties; }
+
+        // First property with the id, like Record::FindProperty.
+        [[nodiscard]] const PropertyInfo* Find(uint32_t id) const;
+
+        [[nodiscard]] std::optional<std::string_view> GetString(uint32_t id, size_t index = 0) const;
+        [[nodiscard]] std::optional<std::string_view> GetString(const PropertyInfo& property, size_t index = 0) const;
+
+        // The values of a numeric property whose stored type is exactly T, e.g. uint32_t for Uint32.
+        template <typename T>
+        [[nodiscard]] std::optional<PackedValues<T>> GetValues(const uint32_t id) const {
+            const PropertyInfo* property = Find(id);
+            if (!property || !IsStoredAs<T>(property->type)) {
+                return std::nullopt;
+            }
+            return Values<T>(*property);
+        }
+
+        // Same conversions as Property::GetScalarAs: integer types convert into each other, float and bool
+        // only match themselves.
+        template <typename T>
+        [[nodiscard]] std::optional<T> GetScalarAs(const uint32_t id, const size_t index = 0) const {
+            const PropertyInfo* property = Find(id);
+            if (!property || index >= property->count) {
+                return std::nullopt;
+            }
+            switch (property->type) {
+                case ValueType::UInt8: return Convert<T>(Values<uint8_t>(*property)[index]);
+                case ValueType::UInt16: return Convert<T>(Values<uint16_t>(*property)[index]);
+                case ValueType::UInt32: return Convert<T>(Values<uint32_t>(*property)[index]);
+                case ValueType::SInt32: return Convert<T>(Values<int32_t>(*property)[index]);
+                case ValueType::SInt64: return Convert<T>(Values<int64_t>(*property)[index]);
+                case ValueType::Float32: return Convert<T>(Values<float>(*property)[index]);
+                case ValueType::Bool: return Convert<T>(Values<bool>(*property)[index]);
+                case ValueType::String: break;
+            }
+            return std::nullopt;
+        }
+
+    private:
+        template <typename T>
+        static constexpr bool IsStoredAs(const ValueType type) {
+            if constexpr (std::is_same_v<T, uint8_t>) return type == ValueType::UInt8;
+            else if constexpr (std::is_same_v<T, uint16_t>) return type == ValueType::UInt16;
+            else if constexpr (std::is_same_v<T, uint32_t>) return type == ValueType::UInt32;
+            else if constexpr (std::is_same_v<T, int32_t>) return type == ValueType::SInt32;
+            else if constexpr (std::is_same_v<T, int64_t>) return type == ValueType::SInt64;
+            else if constexpr (std::is_same_v<T, float>) return type == ValueType::Float32;
+            else if constexpr (std::is_same_v<T, bool>) return type == ValueType::Bool;
+            else return false;
+        }
+
+        template <typename T, typename V>
+        static std::optional<T> Convert(const V value) {
+            if constexpr (std::is_same_v<T, V>) {
+                return value;
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_integral_v<V> && !std::is_same_v<V, bool>) {
+                return static_cast<T>(value);
+            }
+            else {
+                return std::nullopt;
+            }
+        }
+
+        template <typename T>
+        [[nodiscard]] PackedValues<T> Values(const PropertyInfo& property) const {
+            return PackedValues<T>(mBuffer.subspan(property.offset, property.size));
+        }
+
+        std::span<const uint8_t> mBuffer;
+        DBPF::Tgi mParent{};
+        bool mIsCohort = false;
+        std::vector<PropertyInfo> mProperties;
+    };
+
 } // namespace Exemplar
@@ -6,6 +6,7 @@
 
 #include "QFSDecompressor.h"
 #include "SafeSpanReader.h"
+#include "Trace.h"
 
 namespace {
 
@@ -37,6 +38,7 @@ std::string MakeName(const char name[4]) {
 namespace FSH {
 
 ParseExpected<Record> Reader::Parse(std::span<const uint8_t> buffer) {
+    DBPFKIT_TRACE_SCOPE_BYTES("parse", "FSH::Parse", buffer.size());
     if (buffer.size() < sizeof(FileHeader)) {
         return Fail("Buffer too small for FSH header");
     }
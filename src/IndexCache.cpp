@@ -0,0 +1,234 @@
+#include "IndexCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <print>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+    constexpr uint32_t kCacheMagic = 0x43504244; // "DBPC"
+    constexpr uint32_t kCacheVersion = 2;
+
+    struct FileHeader {
+        uint32_t magic = kCacheMagic;
+        uint32_t version = kCacheVersion;
+        uint32_t archiveCount = 0;
+        uint32_t reserved = 0;
+    };
+
+    struct ArchiveRecord {
+        uint64_t fileSize = 0;
+        int64_t modifiedTime = 0;
+        uint64_t pathOffset = 0;
+        uint64_t entriesOffset = 0;
+        uint32_t pathLength = 0;
+        uint32_t entryCount = 0;
+        uint32_t hasDirectory = 0;
+        DBPF::Header header{};
+    };
+
+    static_assert(std::is_trivially_copyable_v<ArchiveRecord>);
+    static_assert(std::is_trivially_copyable_v<DBPF::PackedIndexEntry>);
+    static_assert(sizeof(FileHeader) == 16);
+    static_assert(sizeof(ArchiveRecord) == 88);
+
+    std::string CacheKey(const std::filesystem::path& path) {
+        std::error_code ec;
+        const auto absolute = std::filesystem::absolute(path, ec);
+        return (ec ? path : absolute).lexically_normal().generic_string();
+    }
+
+    bool StatArchive(const std::filesystem::path& path, uint64_t& size, int64_t& modifiedTime) {
+        std::error_code ec;
+        size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        const auto time = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return false;
+        }
+        modifiedTime = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    uint64_t AlignUp(const uint64_t value, const uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+} // namespace
+
+namespace DBPF {
+
+    bool IndexCache::Open(const std::filesystem::path& cacheFile) {
+        Close();
+        if (!mFile.Open(cacheFile) || !mFile.IsWholeFileMapped()) {
+            Close();
+            return false;
+        }
+
+        io::MappedFile::Range whole;
+        if (!mFile.MapRange(0, mFile.FileSize(), whole)) {
+            Close();
+            return false;
+        }
+        const auto bytes = whole.View();
+
+        FileHeader fileHeader;
+        if (bytes.size() < sizeof(fileHeader)) {
+            Close();
+            return false;
+        }
+        std::memcpy(&fileHeader, bytes.data(), sizeof(fileHeader));
+        if (fileHeader.magic != kCacheMagic || fileHeader.version != kCacheVersion) {
+            std::println("[DBPF] Ignoring index cache {} (unknown format)", cacheFile.string());
+            Close();
+            return false;
+        }
+
+        const uint64_t recordsEnd = sizeof(FileHeader) + uint64_t{fileHeader.archiveCount} * sizeof(ArchiveRecord);
+        if (recordsEnd > bytes.size()) {
+            std::println("[DBPF] Ignoring truncated index cache {}", cacheFile.string());
+            Close();
+            return false;
+        }
+
+        mArchives.reserve(fileHeader.archiveCount);
+        for (uint32_t i = 0; i < fileHeader.archiveCount; ++i) {
+            ArchiveRecord record;
+            std::memcpy(&record, bytes.data() + sizeof(FileHeader) + i * sizeof(ArchiveRecord), sizeof(record));
+
+            const uint64_t entriesBytes = uint64_t{record.entryCount} * sizeof(PackedIndexEntry);
+            // Compared without adding to the offsets, which a corrupt record could make wrap around.
+            if (record.pathOffset > bytes.size() || record.pathLength > bytes.size() - record.pathOffset ||
+                record.entriesOffset % alignof(PackedIndexEntry) != 0 ||
+                record.entriesOffset > bytes.size() || entriesBytes > bytes.size() - record.entriesOffset) {
+                std::println("[DBPF] Ignoring corrupt index cache {}", cacheFile.string());
+                Close();
+                return false;
+            }
+
+            CachedArchive archive;
+            archive.fileSize = record.fileSize;
+            archive.modifiedTime = record.modifiedTime;
+            archive.index.header = record.header;
+            archive.index.hasDirectory = record.hasDirectory != 0;
+            archive.index.entries = std::span<const PackedIndexEntry>(
+                reinterpret_cast<const PackedIndexEntry*>(bytes.data() + record.entriesOffset), record.entryCount);
+
+            std::string key(reinterpret_cast<const char*>(bytes.data() + record.pathOffset), record.pathLength);
+            mArchives.insert_or_assign(std::move(key), archive);
+        }
+        return true;
+    }
+
+    void IndexCache::Close() {
+        mArchives.clear();
+        mFile.Close();
+    }
+
+    std::optional<PrecomputedIndex> IndexCache::Lookup(const std::filesystem::path& archive) const {
+        const auto it = mArchives.find(CacheKey(archive));
+        if (it == mArchives.end()) {
+            return std::nullopt;
+        }
+
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        if (!StatArchive(archive, size, modifiedTime) || size != it->second.fileSize ||
+            modifiedTime != it->second.modifiedTime) {
+            return std::nullopt;
+        }
+        return it->second.index;
+    }
+
+    bool IndexCache::Save(const std::filesystem::path& cacheFile, std::span<const Source> sources) {
+        std::vector<ArchiveRecord> records;
+        std::vector<std::string> keys;
+        std::vector<std::vector<PackedIndexEntry>> indexes;
+        records.reserve(sources.size());
+        keys.reserve(sources.size());
+        indexes.reserve(sources.size());
+
+        for (const auto& source : sources) {
+            if (!source.reader) {
+                continue;
+            }
+            ArchiveRecord record;
+            if (!StatArchive(source.path, record.fileSize, record.modifiedTime)) {
+                continue;
+            }
+            auto packed = source.reader->GetPackedIndex();
+            if (!packed) {
+                continue;
+            }
+            record.entryCount = static_cast<uint32_t>(packed->size());
+            record.hasDirectory = source.reader->HasDirectory() ? 1 : 0;
+            record.header = source.reader->GetHeader();
+            records.push_back(record);
+            keys.push_back(CacheKey(source.path));
+            indexes.push_back(std::move(*packed));
+        }
+
+        uint64_t offset = sizeof(FileHeader) + records.size() * sizeof(ArchiveRecord);
+        for (size_t i = 0; i < records.size(); ++i) {
+            records[i].pathOffset = offset;
+            records[i].pathLength = static_cast<uint32_t>(keys[i].size());
+            offset += keys[i].size();
+        }
+        for (size_t i = 0; i < records.size(); ++i) {
+            offset = AlignUp(offset, alignof(uint64_t));
+            records[i].entriesOffset = offset;
+            offset += indexes[i].size() * sizeof(PackedIndexEntry);
+        }
+
+        auto temporary = cacheFile;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::println("[DBPF] Failed to write index cache {}", temporary.string());
+                return false;
+            }
+
+            uint64_t written = 0;
+            auto write = [&](const void* data, const size_t size) {
+                out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                written += size;
+            };
+            auto padTo = [&](const uint64_t target) {
+                constexpr char kZeros[8]{};
+                write(kZeros, target - written);
+            };
+
+            FileHeader fileHeader;
+            fileHeader.archiveCount = static_cast<uint32_t>(records.size());
+            write(&fileHeader, sizeof(fileHeader));
+            write(records.data(), records.size() * sizeof(ArchiveRecord));
+            for (const auto& key : keys) {
+                write(key.data(), key.size());
+            }
+            for (size_t i = 0; i < records.size(); ++i) {
+                padTo(records[i].entriesOffset);
+                write(indexes[i].data(), indexes[i].size() * sizeof(PackedIndexEntry));
+            }
+            if (!out) {
+                std::println("[DBPF] Failed to write index cache {}", temporary.string());
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temporary, cacheFile, ec);
+        if (ec) {
+            std::println("[DBPF] Failed to replace index cache {}: {}", cacheFile.string(), ec.message());
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace DBPF
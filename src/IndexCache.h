@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "DBPFReader.h"
+#include "MappedFile.h"
+
+namespace DBPF {
+
+    // Memory-mapped cache of parsed archive indexes, keyed by absolute path, file size and modification time.
+    // Entries are stored as PackedIndexEntry arrays in native byte order and handed out as spans into the
+    // mapping, so a hit costs one stat and no parsing. A cache written on a machine with a different byte order
+    // fails the magic check and is ignored.
+    class IndexCache {
+    public:
+        struct Source {
+            std::filesystem::path path;
+            const Reader* reader = nullptr;
+        };
+
+        bool Open(const std::filesystem::path& cacheFile);
+        void Close();
+        [[nodiscard]] bool IsOpen() const { return mFile.IsOpen(); }
+        [[nodiscard]] size_t ArchiveCount() const { return mArchives.size(); }
+
+        // The cached index for the archive, or nullopt if it is missing or the file changed since it was cached.
+        // The spans stay valid until the cache is closed.
+        [[nodiscard]] std::optional<PrecomputedIndex> Lookup(const std::filesystem::path& archive) const;
+
+        // Writes the indexes of the given loaded readers, replacing cacheFile atomically.
+        static bool Save(const std::filesystem::path& cacheFile, std::span<const Source> sources);
+
+    private:
+        struct CachedArchive {
+            uint64_t fileSize = 0;
+            int64_t modifiedTime = 0;
+            PrecomputedIndex index;
+        };
+
+        io::MappedFile mFile;
+        std::unordered_map<std::string, CachedArchive> mArchives;
+    };
+
+} // namespace DBPF
@@ -3,6 +3,8 @@
 #include <cstring>
 #include <string_view>
 
+#include "Trace.h"
+
 namespace {
 
     constexpr uint16_t kControlChar = 0x1000;
@@ -107,6 +109,7 @@ namespace LText {
     }
 
     ParseExpected<Record> Parse(std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE_BYTES("parse", "LText::Parse", buffer.size());
         if (buffer.empty()) {
             return Fail("LText payload is empty");
         }
@@ -1,9 +1,200 @@
 #include "MappedFile.h"
 
 #include <algorithm>
-#include <fstream>
 #include <print>
 #include <system_error>
+#include <utility>
+
+#include "Trace.h"
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <cerrno>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+#if defined(DBPFKIT_HAS_LIBURING)
+#    include <liburing.h>
+#endif
+
+namespace {
+
+    struct PendingRead {
+        uint64_t offset = 0;
+        std::span<uint8_t> buffer{};
+        bool done = false;
+        bool inFlight = false;
+    };
+
+    mio::file_handle_type OpenReadHandle(const std::filesystem::path& path) {
+#ifdef _WIN32
+        const HANDLE handle = ::CreateFileW(path.c_str(), GENERIC_READ,
+                                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle == INVALID_HANDLE_VALUE ? mio::invalid_handle : handle;
+#else
+        int fd = -1;
+        do {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        } while (fd < 0 && errno == EINTR);
+        return fd < 0 ? mio::invalid_handle : fd;
+#endif
+    }
+
+    bool ReadAtHandle(const mio::file_handle_type handle, const uint64_t offset, std::span<uint8_t> out) {
+        size_t done = 0;
+        while (done < out.size()) {
+#ifdef _WIN32
+            const uint64_t position = offset + done;
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFu);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+            const auto chunk = static_cast<DWORD>(std::min<size_t>(out.size() - done, size_t{1} << 30));
+            DWORD read = 0;
+            if (!::ReadFile(handle, out.data() + done, chunk, &read, &overlapped) || read == 0) {
+                return false;
+            }
+#else
+            const ssize_t read = ::pread(handle, out.data() + done, out.size() - done,
+                                         static_cast<off_t>(offset + done));
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                return false;
+            }
+#endif
+            done += static_cast<size_t>(read);
+        }
+        return true;
+    }
+
+#if defined(DBPFKIT_HAS_LIBURING)
+    int WaitForCompletion(io_uring& ring, io_uring_cqe*& cqe) {
+        int result = 0;
+        do {
+            result = io_uring_wait_cqe(&ring, &cqe);
+        } while (result == -EINTR);
+        return result;
+    }
+
+    void CompleteRead(io_uring& ring, io_uring_cqe* cqe) {
+        if (auto* read = static_cast<PendingRead*>(io_uring_cqe_get_data(cqe))) {
+            read->done = cqe->res >= 0 && static_cast<size_t>(cqe->res) == read->buffer.size();
+            read->inFlight = false;
+        }
+        io_uring_cqe_seen(&ring, cqe);
+    }
+
+    // Reads that were prepared but are still in the submission queue never reached the kernel. The ring is not
+    // submitted again once this is called, so they are left to the pread fallback.
+    void ReleaseQueued(std::span<PendingRead> prepared, const unsigned queued) {
+        for (auto& read : prepared.last(queued)) {
+            read.inFlight = false;
+        }
+    }
+
+    // The kernel keeps writing into the buffers of in-flight reads until they complete, and those buffers are
+    // reused by the pread fallback, so the ring must not be torn down before then. Cancels whatever is still
+    // outstanding and waits for every completion the kernel accepted, including those of the cancel requests.
+    void DrainRing(io_uring& ring, std::span<PendingRead> prepared, unsigned inFlight, const unsigned queued) {
+        for (auto& read : prepared) {
+            if (!read.inFlight) {
+                continue;
+            }
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            if (!sqe) {
+                break;
+            }
+            io_uring_prep_cancel(sqe, &read, 0);
+            io_uring_sqe_set_data(sqe, nullptr);
+        }
+
+        // The queue is consumed in order: still-queued reads first, then the cancel requests.
+        const int submitted = io_uring_submit(&ring);
+        const unsigned accepted = submitted > 0 ? static_cast<unsigned>(submitted) : 0;
+        if (accepted < queued) {
+            ReleaseQueued(prepared, queued - accepted);
+        }
+        inFlight += accepted;
+
+        while (inFlight > 0) {
+            io_uring_cqe* cqe = nullptr;
+            // Failing here cannot leave the reads safe to abandon, so keep waiting; file reads always complete.
+            if (WaitForCompletion(ring, cqe) < 0) {
+                continue;
+            }
+            CompleteRead(ring, cqe);
+            --inFlight;
+        }
+    }
+
+    // Completes as many reads as possible through one ring. Reads that fail or come back short are left
+    // with done == false for the caller to finish with pread.
+    void ReadWithUring(const int fd, std::span<PendingRead> reads) {
+        constexpr size_t kMaxQueueDepth = 256;
+        const auto depth = static_cast<unsigned>(std::min(reads.size(), kMaxQueueDepth));
+        io_uring ring{};
+        if (depth == 0 || io_uring_queue_init(depth, &ring, 0) < 0) {
+            return;
+        }
+
+        size_t next = 0;
+        // Accepted by the kernel and not yet completed.
+        unsigned inFlight = 0;
+        // Prepared, but still waiting in the submission queue.
+        unsigned queued = 0;
+        bool submitFailed = false;
+        while ((next < reads.size() && !submitFailed) || inFlight > 0) {
+            while (!submitFailed && next < reads.size() && inFlight + queued < depth) {
+                io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+                if (!sqe) {
+                    break;
+                }
+                auto& read = reads[next++];
+                io_uring_prep_read(sqe, fd, read.buffer.data(), static_cast<unsigned>(read.buffer.size()),
+                                   read.offset);
+                io_uring_sqe_set_data(sqe, &read);
+                read.inFlight = true;
+                ++queued;
+            }
+            if (queued > 0) {
+                const int submitted = io_uring_submit(&ring);
+                if (submitted <= 0) {
+                    submitFailed = true;
+                    ReleaseQueued(reads.first(next), queued);
+                    queued = 0;
+                }
+                else {
+                    inFlight += static_cast<unsigned>(submitted);
+                    queued -= static_cast<unsigned>(submitted);
+                }
+            }
+            if (inFlight == 0) {
+                break;
+            }
+
+            io_uring_cqe* cqe = nullptr;
+            if (WaitForCompletion(ring, cqe) < 0) {
+                DrainRing(ring, reads.first(next), inFlight, queued);
+                inFlight = 0;
+                queued = 0;
+                break;
+            }
+            CompleteRead(ring, cqe);
+            --inFlight;
+        }
+        if (queued > 0) {
+            ReleaseQueued(reads.first(next), queued);
+        }
+        io_uring_queue_exit(&ring);
+    }
+#endif
+
+} // namespace
 
 namespace io {
 
@@ -15,7 +206,34 @@ namespace io {
         mSpan = {};
     }
 
-    bool MappedFile::Open(const std::filesystem::path& path) {
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        mPath(std::move(other.mPath)),
+        mWholeMap(std::move(other.mWholeMap)),
+        mHandle(std::exchange(other.mHandle, mio::invalid_handle)),
+        mFileSize(std::exchange(other.mFileSize, 0)),
+        mMode(other.mMode),
+        mUseReadFallback(std::exchange(other.mUseReadFallback, false)),
+        mIsOpen(std::exchange(other.mIsOpen, false)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            mPath = std::move(other.mPath);
+            mWholeMap = std::move(other.mWholeMap);
+            mHandle = std::exchange(other.mHandle, mio::invalid_handle);
+            mFileSize = std::exchange(other.mFileSize, 0);
+            mMode = other.mMode;
+            mUseReadFallback = std::exchange(other.mUseReadFallback, false);
+            mIsOpen = std::exchange(other.mIsOpen, false);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    bool MappedFile::Open(const std::filesystem::path& path, const MappingMode mode) {
         Close();
 
         std::error_code ec;
@@ -25,80 +243,219 @@ namespace io {
             return false;
         }
 
+        mHandle = OpenReadHandle(path);
+        if (mHandle == mio::invalid_handle) {
+            std::println("[MappedFile] Failed to open {}", path.string());
+            return false;
+        }
+
         mPath = path;
         mFileSize = static_cast<uint64_t>(size);
+        mMode = mode;
         mIsOpen = true;
+
+        if (mFileSize == 0) {
+            return true;
+        }
+
+        if (mode == MappingMode::kNoMapping) {
+            mUseReadFallback = true;
+            return true;
+        }
+
+        // A failed mapping is not fatal: every access then goes through positional reads on mHandle.
+        if (mode == MappingMode::kWholeFile) {
+            mWholeMap.map(mHandle, 0, static_cast<size_t>(mFileSize), ec);
+            if (ec && mWholeMap.is_mapped()) {
+                mWholeMap.unmap();
+            }
+        }
+        else {
+            mio::mmap_source probe;
+            probe.map(mHandle, 0, 1, ec);
+        }
+        mUseReadFallback = static_cast<bool>(ec);
         return true;
     }
 
     void MappedFile::Close() {
+        if (mWholeMap.is_mapped()) {
+            mWholeMap.unmap();
+        }
+        CloseHandle();
         mIsOpen = false;
+        mUseReadFallback = false;
         mFileSize = 0;
         mPath.clear();
     }
 
+    void MappedFile::CloseHandle() {
+        if (mHandle == mio::invalid_handle) {
+            return;
+        }
+#ifdef _WIN32
+        ::CloseHandle(mHandle);
+#else
+        ::close(mHandle);
+#endif
+        mHandle = mio::invalid_handle;
+    }
+
+    bool MappedFile::CheckBounds(const uint64_t offset, const size_t length) const {
+        return offset <= mFileSize && length <= mFileSize - offset;
+    }
+
     bool MappedFile::MapRange(uint64_t offset, size_t length, Range& outRange) const {
+        DBPFKIT_TRACE_SCOPE_BYTES("io", "MapRange", length);
         if (!mIsOpen) {
             return false;
         }
-        if (offset > mFileSize) {
-            return false;
-        }
-        const uint64_t clampedLength = std::min<uint64_t>(length, mFileSize - offset);
-        if (length > clampedLength) {
+        if (!CheckBounds(offset, length)) {
             return false;
         }
 
         outRange.Reset();
-        if (clampedLength == 0) {
+        if (length == 0) {
             return true;
         }
 
-        std::error_code ec;
-        outRange.mMap.map(mPath.native(),
-                          static_cast<size_t>(offset),
-                          static_cast<size_t>(clampedLength),
-                          ec);
-        if (!ec && outRange.mMap.is_mapped()) {
+        if (mWholeMap.is_mapped()) {
             outRange.mSpan = std::span<const uint8_t>(
-                reinterpret_cast<const uint8_t*>(outRange.mMap.data()),
-                outRange.mMap.length());
+                reinterpret_cast<const uint8_t*>(mWholeMap.data()) + offset, length);
             return true;
         }
 
-        if (outRange.mMap.is_mapped()) {
-            outRange.mMap.unmap();
+        if (!mUseReadFallback) {
+            std::error_code ec;
+            outRange.mMap.map(mHandle, static_cast<size_t>(offset), length, ec);
+            if (!ec && outRange.mMap.is_mapped()) {
+                outRange.mSpan = std::span<const uint8_t>(
+                    reinterpret_cast<const uint8_t*>(outRange.mMap.data()),
+                    outRange.mMap.length());
+                return true;
+            }
+
+            if (outRange.mMap.is_mapped()) {
+                outRange.mMap.unmap();
+            }
         }
 
-        const bool fallbackResult = ReadFallback(offset, static_cast<size_t>(clampedLength), outRange);
+        const bool fallbackResult = ReadFallback(offset, length, outRange);
         if (!fallbackResult) {
             outRange.Reset();
         }
         return fallbackResult;
     }
 
-    bool MappedFile::ReadFallback(uint64_t offset, size_t length, Range& outRange) const {
-        std::ifstream file(mPath, std::ios::binary);
-        if (!file) {
-            return false;
+    bool MappedFile::MapRanges(std::span<RangeRequest> requests) const {
+        if (!mUseReadFallback) {
+            bool allOk = true;
+            for (auto& request : requests) {
+                request.ok = MapRange(request.offset, request.length, request.range);
+                allOk = allOk && request.ok;
+            }
+            return allOk;
         }
+        return ReadBatchFallback(requests);
+    }
 
-        file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-        if (!file) {
+    bool MappedFile::ReadAt(const uint64_t offset, std::span<uint8_t> out) const {
+        if (!mIsOpen || !CheckBounds(offset, out.size())) {
             return false;
         }
+        return ReadAtHandle(mHandle, offset, out);
+    }
+
+    void MappedFile::PrefetchRange(uint64_t offset, uint64_t length) const {
+        if (!mIsOpen || offset >= mFileSize || length == 0) {
+            return;
+        }
+        length = std::min(length, mFileSize - offset);
+
+        if (mWholeMap.is_mapped()) {
+#ifdef _WIN32
+            WIN32_MEMORY_RANGE_ENTRY entry{};
+            entry.VirtualAddress = const_cast<char*>(mWholeMap.data() + offset);
+            entry.NumberOfBytes = static_cast<SIZE_T>(length);
+            ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &entry, 0);
+#else
+            static const uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+            const uint64_t alignedOffset = offset - offset % pageSize;
+            ::madvise(const_cast<char*>(mWholeMap.data() + alignedOffset),
+                      static_cast<size_t>(length + (offset - alignedOffset)), MADV_WILLNEED);
+#endif
+            return;
+        }
+
+#if defined(POSIX_FADV_WILLNEED)
+        ::posix_fadvise(mHandle, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#endif
+    }
+
+    void MappedFile::ReleaseRange(uint64_t offset, uint64_t length) const {
+#ifndef _WIN32
+        if (!mWholeMap.is_mapped() || offset >= mFileSize) {
+            return;
+        }
+        static const uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        const uint64_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+        const uint64_t end = std::min(offset + length, mFileSize) / pageSize * pageSize;
+        if (end > begin) {
+            ::madvise(const_cast<char*>(mWholeMap.data() + begin), static_cast<size_t>(end - begin), MADV_DONTNEED);
+        }
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
 
+    bool MappedFile::ReadFallback(uint64_t offset, size_t length, Range& outRange) const {
         outRange.mFallback.resize(length);
-        if (length > 0) {
-            file.read(reinterpret_cast<char*>(outRange.mFallback.data()), static_cast<std::streamsize>(length));
-            if (!file) {
-                outRange.mFallback.clear();
-                return false;
-            }
+        if (!ReadAt(offset, outRange.mFallback)) {
+            outRange.mFallback.clear();
+            return false;
         }
 
         outRange.mSpan = std::span<const uint8_t>(outRange.mFallback.data(), outRange.mFallback.size());
         return true;
     }
 
+    bool MappedFile::ReadBatchFallback(std::span<RangeRequest> requests) const {
+        std::vector<PendingRead> reads;
+        std::vector<RangeRequest*> owners;
+        reads.reserve(requests.size());
+        owners.reserve(requests.size());
+
+        for (auto& request : requests) {
+            request.range.Reset();
+            request.ok = mIsOpen && CheckBounds(request.offset, request.length);
+            if (!request.ok || request.length == 0) {
+                continue;
+            }
+            request.range.mFallback.resize(request.length);
+            reads.push_back(PendingRead{request.offset, request.range.mFallback});
+            owners.push_back(&request);
+        }
+
+#if defined(DBPFKIT_HAS_LIBURING)
+        ReadWithUring(mHandle, reads);
+#endif
+
+        bool allOk = true;
+        for (size_t i = 0; i < reads.size(); ++i) {
+            auto& request = *owners[i];
+            request.ok = reads[i].done || ReadAtHandle(mHandle, reads[i].offset, reads[i].buffer);
+            if (request.ok) {
+                request.range.mSpan = std::span<const uint8_t>(request.range.mFallback.data(), request.length);
+            }
+            else {
+                request.range.Reset();
+            }
+        }
+        for (const auto& request : requests) {
+            allOk = allOk && request.ok;
+        }
+        return allOk;
+    }
+
 } // namespace io
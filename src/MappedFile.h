@@ -11,6 +11,13 @@ namespace io {
 
     class MappedFile {
     public:
+        enum class MappingMode {
+            kWholeFile, // map the archive once at Open and hand out sub-spans
+            kPerRange,  // map each requested range separately (for 32-bit address spaces)
+            kNoMapping  // never map; serve every range through positional reads
+        };
+
+        // In whole-file mode a Range only borrows from the owning MappedFile and must not outlive it.
         class Range {
         public:
             Range() = default;
@@ -22,6 +29,8 @@ namespace io {
 
             [[nodiscard]] std::span<const uint8_t> View() const { return mSpan; }
             [[nodiscard]] bool Empty() const { return mSpan.empty(); }
+            // True when the bytes were copied in with a positional read instead of mapped.
+            [[nodiscard]] bool UsesReadFallback() const { return !mFallback.empty(); }
 
         private:
             friend class MappedFile;
@@ -32,27 +41,55 @@ namespace io {
             std::span<const uint8_t> mSpan{};
         };
 
+        struct RangeRequest {
+            uint64_t offset = 0;
+            size_t length = 0;
+            Range range;
+            bool ok = false;
+        };
+
         MappedFile() = default;
         MappedFile(const MappedFile&) = delete;
         MappedFile& operator=(const MappedFile&) = delete;
-        MappedFile(MappedFile&&) noexcept = default;
-        MappedFile& operator=(MappedFile&&) noexcept = default;
-        ~MappedFile() = default;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
 
-        bool Open(const std::filesystem::path& path);
+        bool Open(const std::filesystem::path& path, MappingMode mode = MappingMode::kWholeFile);
         void Close();
 
         [[nodiscard]] bool IsOpen() const { return mIsOpen; }
+        [[nodiscard]] MappingMode Mode() const { return mMode; }
+        [[nodiscard]] bool IsWholeFileMapped() const { return mWholeMap.is_mapped(); }
+        // True when mapping is disabled or was refused by the file system, so every access goes through
+        // positional reads.
+        [[nodiscard]] bool UsesReadFallback() const { return mUseReadFallback; }
         [[nodiscard]] uint64_t FileSize() const { return mFileSize; }
         [[nodiscard]] const std::filesystem::path& Path() const { return mPath; }
 
         bool MapRange(uint64_t offset, size_t length, Range& outRange) const;
+        // Fills every request and returns true if all of them succeeded. When reads go through the fallback
+        // path they are submitted as one io_uring batch where available, or as a pread loop otherwise.
+        bool MapRanges(std::span<RangeRequest> requests) const;
+        // Positional read that never touches a shared file position, so it is safe to call concurrently.
+        bool ReadAt(uint64_t offset, std::span<uint8_t> out) const;
+        // Hints that the range will be read soon (madvise on the mapping, posix_fadvise otherwise).
+        void PrefetchRange(uint64_t offset, uint64_t length) const;
+        // Drops the whole pages of an already consumed range from the process' working set.
+        void ReleaseRange(uint64_t offset, uint64_t length) const;
 
     private:
+        bool CheckBounds(uint64_t offset, size_t length) const;
         bool ReadFallback(uint64_t offset, size_t length, Range& outRange) const;
+        bool ReadBatchFallback(std::span<RangeRequest> requests) const;
+        void CloseHandle();
 
         std::filesystem::path mPath;
+        mio::mmap_source mWholeMap;
+        mio::file_handle_type mHandle = mio::invalid_handle;
         uint64_t mFileSize = 0;
+        MappingMode mMode = MappingMode::kWholeFile;
+        bool mUseReadFallback = false;
         bool mIsOpen = false;
     };
 
@@ -0,0 +1,401 @@
+#include "PluginSet.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+
+#include "ExemplarReader.h"
+#include "FSHReader.h"
+#include "IndexCache.h"
+#include "LTextReader.h"
+#include "S3DReader.h"
+#include "ThreadPool.h"
+
+namespace {
+
+    constexpr std::array<std::string_view, 4> kPluginExtensions{".dat", ".sc4lot", ".sc4desc", ".sc4model"};
+
+    std::string ToLower(std::string value) {
+        std::ranges::transform(value, value.begin(), [](const unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return value;
+    }
+
+    void SortByName(std::vector<std::filesystem::path>& paths) {
+        std::ranges::sort(paths, {}, [](const std::filesystem::path& path) {
+            const auto name = path.filename().string();
+            return std::pair(ToLower(name), name);
+        });
+    }
+
+    void CollectDirectory(const std::filesystem::path& directory, std::vector<std::filesystem::path>& out) {
+        std::vector<std::filesystem::path> files;
+        std::vector<std::filesystem::path> subdirectories;
+
+        std::error_code ec;
+        for (const auto& item : std::filesystem::directory_iterator(directory, ec)) {
+            std::error_code statusEc;
+            if (item.is_directory(statusEc)) {
+                subdirectories.push_back(item.path());
+            } else if (item.is_regular_file(statusEc) && DBPF::PluginSet::IsPluginFile(item.path())) {
+                files.push_back(item.path());
+            }
+        }
+        if (ec) {
+            std::println("[DBPF] Failed to list {}: {}", directory.string(), ec.message());
+            return;
+        }
+
+        SortByName(files);
+        SortByName(subdirectories);
+        out.insert(out.end(), files.begin(), files.end());
+        for (const auto& subdirectory : subdirectories) {
+            CollectDirectory(subdirectory, out);
+        }
+    }
+
+} // namespace
+
+namespace DBPF {
+
+    size_t PluginSet::LoadDirectories(std::span<const std::filesystem::path> roots, ThreadPool* pool,
+                                      const IndexCache* cache) {
+        std::vector<std::filesystem::path> files;
+        for (const auto& root : roots) {
+            CollectDirectory(root, files);
+        }
+        const size_t loaded = LoadFiles(files, pool, cache);
+        mRoots.assign(roots.begin(), roots.end());
+        return loaded;
+    }
+
+    size_t PluginSet::LoadFiles(std::span<const std::filesystem::path> files, ThreadPool* pool,
+                                const IndexCache* cache) {
+        Clear();
+
+        std::vector<std::unique_ptr<Reader>> readers(files.size());
+        std::vector<char> loaded(files.size(), 0);
+        std::vector<char> cached(files.size(), 0);
+        auto& workers = pool ? *pool : ThreadPool::Shared();
+        workers.ParallelFor(files.size(), [&](const size_t i) {
+            readers[i] = std::make_unique<Reader>();
+            if (cache) {
+                if (const auto index = cache->Lookup(files[i]); index && readers[i]->LoadFile(files[i], *index)) {
+                    loaded[i] = 1;
+                    cached[i] = 1;
+                    return;
+                }
+            }
+            loaded[i] = readers[i]->LoadFile(files[i]) ? 1 : 0;
+        });
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            mCacheHits += cached[i];
+            if (!loaded[i]) {
+                std::println("[DBPF] Failed to load plugin {}", files[i].string());
+                mFailedFiles.push_back(files[i]);
+                continue;
+            }
+            IndexArchive(AddArchive(files[i], std::move(readers[i])));
+        }
+        return mLoadOrder.size();
+    }
+
+    void PluginSet::Clear() {
+        mEntries.clear();
+        mArchives.clear();
+        mFreeArchives.clear();
+        mLoadOrder.clear();
+        mRoots.clear();
+        mFailedFiles.clear();
+        mCacheHits = 0;
+    }
+
+    std::vector<Tgi> PluginSet::Refresh(std::span<const std::filesystem::path> modified, ThreadPool* pool) {
+        mFailedFiles.clear();
+        std::vector<std::filesystem::path> files;
+        if (mRoots.empty()) {
+            for (const uint32_t archive : mLoadOrder) {
+                std::error_code ec;
+                if (std::filesystem::exists(mArchives[archive].path, ec)) {
+                    files.push_back(mArchives[archive].path);
+                }
+            }
+        } else {
+            for (const auto& root : mRoots) {
+                CollectDirectory(root, files);
+            }
+        }
+
+        std::unordered_map<std::string, uint32_t> archivesByPath;
+        for (const uint32_t archive : mLoadOrder) {
+            archivesByPath.emplace(mArchives[archive].path.lexically_normal().string(), archive);
+        }
+        std::unordered_set<std::string> modifiedPaths;
+        for (const auto& path : modified) {
+            modifiedPaths.insert(path.lexically_normal().string());
+        }
+
+        // Work out which files need (re)loading; archives that were not listed any more have been removed.
+        struct Pending {
+            std::filesystem::path path;
+            std::optional<uint32_t> archive;
+            std::unique_ptr<Reader> reader;
+        };
+        std::vector<Pending> pending;
+        std::unordered_set<uint32_t> listed;
+        for (const auto& file : files) {
+            const auto key = file.lexically_normal().string();
+            const auto it = archivesByPath.find(key);
+            if (it == archivesByPath.end()) {
+                pending.push_back(Pending{file, std::nullopt, nullptr});
+                continue;
+            }
+            listed.insert(it->second);
+            if (modifiedPaths.contains(key)) {
+                pending.push_back(Pending{file, it->second, nullptr});
+            }
+        }
+
+        auto& workers = pool ? *pool : ThreadPool::Shared();
+        workers.ParallelFor(pending.size(), [&](const size_t i) {
+            auto reader = std::make_unique<Reader>();
+            if (reader->LoadFile(pending[i].path)) {
+                pending[i].reader = std::move(reader);
+            }
+        });
+
+        // TGIs whose winner may change: everything the old and new versions of the touched archives contain.
+        std::unordered_set<Tgi, TgiHash> affected;
+        auto collect = [&](const Reader& reader) {
+            for (const auto& entry : reader.GetIndex()) {
+                if (entry.tgi != kDirectoryTgi) {
+                    affected.insert(entry.tgi);
+                }
+            }
+        };
+
+        std::unordered_set<uint32_t> touched;
+        auto remove = [&](const uint32_t archive) {
+            collect(*mArchives[archive].reader);
+            archivesByPath.erase(mArchives[archive].path.lexically_normal().string());
+            mArchives[archive] = Archive{};
+            mFreeArchives.push_back(archive);
+            touched.insert(archive);
+        };
+        for (const uint32_t archive : mLoadOrder) {
+            if (!listed.contains(archive)) {
+                remove(archive);
+            }
+        }
+
+        std::unordered_map<std::string, uint32_t> loadedByPath;
+        for (auto& item : pending) {
+            if (!item.reader) {
+                std::println("[DBPF] Failed to load plugin {}", item.path.string());
+                mFailedFiles.push_back(item.path);
+                if (item.archive) {
+                    remove(*item.archive);
+                }
+                continue;
+            }
+            collect(*item.reader);
+            uint32_t archive = 0;
+            if (item.archive) {
+                archive = *item.archive;
+                collect(*mArchives[archive].reader);
+                mArchives[archive].reader = std::move(item.reader);
+            } else {
+                archive = AddArchive(item.path, std::move(item.reader));
+            }
+            touched.insert(archive);
+            loadedByPath.emplace(item.path.lexically_normal().string(), archive);
+        }
+
+        mLoadOrder.clear();
+        for (const auto& file : files) {
+            const auto key = file.lexically_normal().string();
+            auto it = loadedByPath.find(key);
+            if (it == loadedByPath.end()) {
+                it = archivesByPath.find(key);
+                if (it == archivesByPath.end() || !mArchives[it->second].reader) {
+                    continue;
+                }
+            }
+            mArchives[it->second].rank = static_cast<uint32_t>(mLoadOrder.size());
+            mLoadOrder.push_back(it->second);
+        }
+
+        // Untouched archives keep their relative order, so an untouched winner can only be beaten by a touched
+        // archive that now loads later, and a TGI without a winner can only have gained one from a touched
+        // archive. Only a winner that came from a touched archive has to be searched for again.
+        std::vector<Tgi> changed;
+        for (const auto& tgi : affected) {
+            const auto it = mEntries.find(tgi);
+            const bool hadWinner = it != mEntries.end();
+            std::optional<Location> winner;
+            bool winnerTouched = true;
+            if (hadWinner && touched.contains(it->second.archive)) {
+                winner = ResolveWinner(tgi);
+            } else {
+                if (hadWinner) {
+                    winner = it->second;
+                    winnerTouched = false;
+                }
+                for (const uint32_t archive : touched) {
+                    const auto& candidate = mArchives[archive];
+                    if (!candidate.reader || (winner && candidate.rank < mArchives[winner->archive].rank)) {
+                        continue;
+                    }
+                    if (const IndexEntry* entry = candidate.reader->FindEntry(tgi)) {
+                        winner = Location{archive, entry};
+                        winnerTouched = true;
+                    }
+                }
+            }
+
+            if (winnerTouched && (winner || hadWinner)) {
+                changed.push_back(tgi);
+            }
+            if (winner) {
+                mEntries.insert_or_assign(tgi, *winner);
+            } else {
+                mEntries.erase(tgi);
+            }
+        }
+
+        std::ranges::sort(changed);
+        return changed;
+    }
+
+    bool PluginSet::SaveIndexCache(const std::filesystem::path& cacheFile) const {
+        std::vector<IndexCache::Source> sources;
+        sources.reserve(mLoadOrder.size());
+        for (const uint32_t archive : mLoadOrder) {
+            sources.push_back(IndexCache::Source{mArchives[archive].path, mArchives[archive].reader.get()});
+        }
+        return IndexCache::Save(cacheFile, sources);
+    }
+
+    std::vector<std::filesystem::path> PluginSet::CollectPluginFiles(const std::filesystem::path& root) {
+        std::vector<std::filesystem::path> files;
+        CollectDirectory(root, files);
+        return files;
+    }
+
+    bool PluginSet::IsPluginFile(const std::filesystem::path& path) {
+        const auto extension = ToLower(path.extension().string());
+        return std::ranges::find(kPluginExtensions, extension) != kPluginExtensions.end();
+    }
+
+    uint32_t PluginSet::AddArchive(std::filesystem::path path, std::unique_ptr<Reader> reader) {
+        uint32_t archive = static_cast<uint32_t>(mArchives.size());
+        if (!mFreeArchives.empty()) {
+            archive = mFreeArchives.back();
+            mFreeArchives.pop_back();
+        } else {
+            mArchives.emplace_back();
+        }
+        mArchives[archive] = Archive{std::move(path), std::move(reader), static_cast<uint32_t>(mLoadOrder.size())};
+        mLoadOrder.push_back(archive);
+        return archive;
+    }
+
+    void PluginSet::IndexArchive(const uint32_t archive) {
+        const Reader& reader = *mArchives[archive].reader;
+        for (const auto& entry : reader.GetIndex()) {
+            // The directory only describes its own archive, and duplicates inside one archive resolve to the
+            // first copy, matching Reader::FindEntry.
+            if (entry.tgi == kDirectoryTgi || reader.FindEntry(entry.tgi) != &entry) {
+                continue;
+            }
+            mEntries.insert_or_assign(entry.tgi, Location{archive, &entry});
+        }
+    }
+
+    std::optional<PluginSet::Location> PluginSet::ResolveWinner(const Tgi& tgi) const {
+        for (auto it = mLoadOrder.rbegin(); it != mLoadOrder.rend(); ++it) {
+            if (const IndexEntry* entry = mArchives[*it].reader->FindEntry(tgi)) {
+                return Location{*it, entry};
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<PluginSet::Location> PluginSet::Find(const Tgi& tgi) const {
+        const auto it = mEntries.find(tgi);
+        if (it == mEntries.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    std::vector<PluginSet::Location> PluginSet::FindEntries(const TgiMask& mask) const {
+        std::vector<Location> matches;
+        for (const uint32_t archive : mLoadOrder) {
+            for (const IndexEntry* entry : mArchives[archive].reader->FindEntries(mask)) {
+                const auto it = mEntries.find(entry->tgi);
+                if (it != mEntries.end() && it->second.entry == entry) {
+                    matches.push_back(it->second);
+                }
+            }
+        }
+        return matches;
+    }
+
+    std::optional<std::vector<uint8_t>> PluginSet::ReadEntryData(const Tgi& tgi) const {
+        const auto location = Find(tgi);
+        if (!location) {
+            return std::nullopt;
+        }
+        return GetArchive(location->archive).ReadEntryData(*location->entry);
+    }
+
+    std::optional<EntryView> PluginSet::ReadEntryView(const Tgi& tgi) const {
+        const auto location = Find(tgi);
+        if (!location) {
+            return std::nullopt;
+        }
+        return GetArchive(location->archive).ReadEntryView(*location->entry);
+    }
+
+    ParseExpected<FSH::Record> PluginSet::LoadFSH(const Tgi& tgi) const {
+        const auto location = Find(tgi);
+        if (!location) {
+            return Fail("No plugin contains {}", tgi.ToString());
+        }
+        return GetArchive(location->archive).LoadFSH(*location->entry);
+    }
+
+    ParseExpected<S3D::Record> PluginSet::LoadS3D(const Tgi& tgi) const {
+        const auto location = Find(tgi);
+        if (!location) {
+            return Fail("No plugin contains {}", tgi.ToString());
+        }
+        return GetArchive(location->archive).LoadS3D(*location->entry);
+    }
+
+    ParseExpected<Exemplar::Record> PluginSet::LoadExemplar(const Tgi& tgi) const {
+        const auto location = Find(tgi);
+        if (!location) {
+            return Fail("No plugin contains {}", tgi.ToString());
+        }
+        return GetArchive(location->archive).LoadExemplar(*location->entry);
+    }
+
+    ParseExpected<LText::Record> PluginSet::LoadLText(const Tgi& tgi) const {
+        const auto location = Find(tgi);
+        if (!location) {
+            return Fail("No plugin contains {}", tgi.ToString());
+        }
+        return GetArchive(location->archive).LoadLText(*location->entry);
+    }
+
+} // namespace DBPF
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "DBPFReader.h"
+#include "DBPFStructures.h"
+#include "ParseTypes.h"
+
+namespace DBPF {
+
+    class IndexCache;
+    class ThreadPool;
+
+    // A whole Plugins tree opened as one catalog. Archives are opened in parallel and resolved in load order:
+    // when several archives contain the same TGI, the one loaded last wins. Within a directory, files load in
+    // case-insensitive alphabetical order before its subdirectories, which are visited the same way. Like Reader,
+    // every const member function may be called concurrently once loading has finished; Refresh counts as a load.
+    class PluginSet {
+    public:
+        // archive is an id that stays valid across Refresh calls until that archive is removed.
+        struct Location {
+            uint32_t archive = 0;
+            const IndexEntry* entry = nullptr;
+        };
+
+        // Collects the plugin files under each root (later roots load after earlier ones) and opens them.
+        // Returns the number of archives that opened successfully. Archives found unchanged in the cache skip
+        // parsing their header and index.
+        size_t LoadDirectories(std::span<const std::filesystem::path> roots, ThreadPool* pool = nullptr,
+                               const IndexCache* cache = nullptr);
+        // Opens the files as given; later files override earlier ones.
+        size_t LoadFiles(std::span<const std::filesystem::path> files, ThreadPool* pool = nullptr,
+                         const IndexCache* cache = nullptr);
+        void Clear();
+        // Re-indexes only the archives that changed and patches the winner table. Files under the roots are
+        // re-listed to pick up additions and removals; modified lists the files whose contents changed. Returns
+        // the TGIs whose winning entry changed, sorted.
+        std::vector<Tgi> Refresh(std::span<const std::filesystem::path> modified, ThreadPool* pool = nullptr);
+        // Writes the indexes of all loaded archives for the next LoadFiles/LoadDirectories call.
+        bool SaveIndexCache(const std::filesystem::path& cacheFile) const;
+
+        // Plugin files below root in the game's load order.
+        [[nodiscard]] static std::vector<std::filesystem::path> CollectPluginFiles(const std::filesystem::path& root);
+        [[nodiscard]] static bool IsPluginFile(const std::filesystem::path& path);
+
+        [[nodiscard]] size_t ArchiveCount() const { return mLoadOrder.size(); }
+        // Archive ids, first loaded first.
+        [[nodiscard]] const std::vector<uint32_t>& GetLoadOrder() const { return mLoadOrder; }
+        [[nodiscard]] const std::vector<std::filesystem::path>& GetRoots() const { return mRoots; }
+        [[nodiscard]] const Reader& GetArchive(uint32_t archive) const { return *mArchives[archive].reader; }
+        [[nodiscard]] const std::filesystem::path& GetArchivePath(uint32_t archive) const {
+            return mArchives[archive].path;
+        }
+        [[nodiscard]] const std::vector<std::filesystem::path>& GetFailedFiles() const { return mFailedFiles; }
+        // Number of archives in the last load whose index came from the cache.
+        [[nodiscard]] size_t GetCacheHitCount() const { return mCacheHits; }
+        // Number of distinct TGIs across all archives.
+        [[nodiscard]] size_t EntryCount() const { return mEntries.size(); }
+
+        [[nodiscard]] std::optional<Location> Find(const Tgi& tgi) const;
+        // Winning entries matching the mask, ordered by archive load order and then by index order within each
+        // archive.
+        [[nodiscard]] std::vector<Location> FindEntries(const TgiMask& mask) const;
+
+        [[nodiscard]] std::optional<std::vector<uint8_t>> ReadEntryData(const Tgi& tgi) const;
+        [[nodiscard]] std::optional<EntryView> ReadEntryView(const Tgi& tgi) const;
+        [[nodiscard]] ParseExpected<FSH::Record> LoadFSH(const Tgi& tgi) const;
+        [[nodiscard]] ParseExpected<S3D::Record> LoadS3D(const Tgi& tgi) const;
+        [[nodiscard]] ParseExpected<Exemplar::Record> LoadExemplar(const Tgi& tgi) const;
+        [[nodiscard]] ParseExpected<LText::Record> LoadLText(const Tgi& tgi) const;
+
+    private:
+        struct Archive {
+            std::filesystem::path path;
+            std::unique_ptr<Reader> reader;
+            uint32_t rank = 0;
+        };
+
+        uint32_t AddArchive(std::filesystem::path path, std::unique_ptr<Reader> reader);
+        void IndexArchive(uint32_t archive);
+        [[nodiscard]] std::optional<Location> ResolveWinner(const Tgi& tgi) const;
+
+        std::vector<Archive> mArchives;
+        std::vector<uint32_t> mFreeArchives;
+        std::vector<uint32_t> mLoadOrder;
+        std::vector<std::filesystem::path> mRoots;
+        std::vector<std::filesystem::path> mFailedFiles;
+        std::unordered_map<Tgi, Location, TgiHash> mEntries;
+        size_t mCacheHits = 0;
+    };
+
+} // namespace DBPF
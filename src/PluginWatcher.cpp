@@ -0,0 +1,187 @@
+#include "PluginWatcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <print>
+#include <system_error>
+
+#include "PluginSet.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace DBPF {
+
+    PluginWatcher::PluginWatcher(PluginSet& plugins, ThreadPool* pool)
+        : mPlugins(plugins)
+        , mPool(pool) {}
+
+    PluginWatcher::~PluginWatcher() {
+        Stop();
+    }
+
+    size_t PluginWatcher::Subscribe(ChangeListener listener) {
+        const size_t id = mNextListenerId++;
+        mListeners.emplace_back(id, std::move(listener));
+        return id;
+    }
+
+    void PluginWatcher::Unsubscribe(const size_t id) {
+        std::erase_if(mListeners, [id](const auto& listener) { return listener.first == id; });
+    }
+
+#ifdef __linux__
+
+    namespace {
+        constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+                                        IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    }
+
+    bool PluginWatcher::Start() {
+        Stop();
+        if (mPlugins.GetRoots().empty()) {
+            std::println("[DBPF] Plugin watcher needs a set loaded with LoadDirectories");
+            return false;
+        }
+
+        mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (mFd < 0) {
+            std::println("[DBPF] inotify_init1 failed: {}", std::generic_category().message(errno));
+            return false;
+        }
+        for (const auto& root : mPlugins.GetRoots()) {
+            AddWatches(root);
+        }
+        return true;
+    }
+
+    void PluginWatcher::Stop() {
+        if (mFd >= 0) {
+            close(mFd);
+            mFd = -1;
+        }
+        mWatches.clear();
+    }
+
+    void PluginWatcher::AddWatches(const std::filesystem::path& directory) {
+        const int wd = inotify_add_watch(mFd, directory.c_str(), kWatchMask);
+        if (wd < 0) {
+            std::println("[DBPF] Failed to watch {}: {}", directory.string(), std::generic_category().message(errno));
+            return;
+        }
+        mWatches[wd] = directory;
+
+        std::error_code ec;
+        for (const auto& item : std::filesystem::directory_iterator(directory, ec)) {
+            std::error_code statusEc;
+            if (item.is_directory(statusEc)) {
+                AddWatches(item.path());
+            }
+        }
+    }
+
+    size_t PluginWatcher::Poll(const int timeoutMs) {
+        if (mFd < 0) {
+            return 0;
+        }
+
+        pollfd descriptor{mFd, POLLIN, 0};
+        if (poll(&descriptor, 1, timeoutMs) <= 0) {
+            return 0;
+        }
+
+        std::vector<std::filesystem::path> modified;
+        bool relevant = false;
+        alignas(inotify_event) char buffer[16 * 1024];
+        while (true) {
+            const ssize_t length = read(mFd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // Events were dropped; reload everything that is loaded and re-list the roots.
+                    relevant = true;
+                    for (const uint32_t archive : mPlugins.GetLoadOrder()) {
+                        modified.push_back(mPlugins.GetArchivePath(archive));
+                    }
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    mWatches.erase(event->wd);
+                    continue;
+                }
+
+                const auto watch = mWatches.find(event->wd);
+                if (watch == mWatches.end()) {
+                    continue;
+                }
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    relevant = true;
+                    continue;
+                }
+                if (event->len == 0) {
+                    continue;
+                }
+
+                const auto path = watch->second / event->name;
+                if (event->mask & IN_ISDIR) {
+                    // A directory appearing or disappearing adds or removes everything under it, which the
+                    // refresh picks up by re-listing the roots.
+                    relevant = true;
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        AddWatches(path);
+                    }
+                    continue;
+                }
+                if (!PluginSet::IsPluginFile(path)) {
+                    continue;
+                }
+                // A file is only complete once it is closed or moved in; creation alone is not enough to read it.
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    modified.push_back(path);
+                    relevant = true;
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    relevant = true;
+                }
+            }
+        }
+
+        if (!relevant) {
+            return 0;
+        }
+
+        const auto changed = mPlugins.Refresh(modified, mPool);
+        if (!changed.empty()) {
+            for (const auto& [id, listener] : mListeners) {
+                listener(changed);
+            }
+        }
+        return changed.size();
+    }
+
+#else
+
+    bool PluginWatcher::Start() {
+        std::println("[DBPF] Plugin watching is only supported on Linux");
+        return false;
+    }
+
+    void PluginWatcher::Stop() {}
+
+    void PluginWatcher::AddWatches(const std::filesystem::path&) {}
+
+    size_t PluginWatcher::Poll(int) {
+        return 0;
+    }
+
+#endif
+
+} // namespace DBPF
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "TGI.h"
+
+namespace DBPF {
+
+    class PluginSet;
+    class ThreadPool;
+
+    // Watches the roots of a PluginSet loaded with LoadDirectories and keeps it current. Poll drains the pending
+    // file system events, refreshes only the archives that were added, removed or rewritten, and passes the TGIs
+    // whose winner changed to every subscriber. Polling mutates the PluginSet, so it must not overlap other calls
+    // on it. Only implemented on Linux (inotify); elsewhere Start fails.
+    class PluginWatcher {
+    public:
+        using ChangeListener = std::function<void(std::span<const Tgi> changed)>;
+
+        explicit PluginWatcher(PluginSet& plugins, ThreadPool* pool = nullptr);
+        PluginWatcher(const PluginWatcher&) = delete;
+        PluginWatcher& operator=(const PluginWatcher&) = delete;
+        ~PluginWatcher();
+
+        bool Start();
+        void Stop();
+        [[nodiscard]] bool IsRunning() const { return mFd >= 0; }
+
+        size_t Subscribe(ChangeListener listener);
+        void Unsubscribe(size_t id);
+
+        // Waits up to timeoutMs for events (0 returns immediately) and applies them. Returns the number of TGIs
+        // whose winner changed.
+        size_t Poll(int timeoutMs = 0);
+
+    private:
+        void AddWatches(const std::filesystem::path& directory);
+
+        PluginSet& mPlugins;
+        ThreadPool* mPool = nullptr;
+        int mFd = -1;
+        std::unordered_map<int, std::filesystem::path> mWatches;
+        std::vector<std::pair<size_t, ChangeListener>> mListeners;
+        size_t mNextListenerId = 1;
+    };
+
+} // namespace DBPF
@@ -0,0 +1,350 @@
+#include "QFSCompressor.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <optional>
+
+#include "QFSDecompressor.h"
+#include "ThreadPool.h"
+
+namespace {
+
+    // Largest offset the long control form can encode.
+    constexpr size_t kWindowSize = 131072;
+    constexpr size_t kMinMatch = 3;
+    constexpr size_t kMaxMatch = 1028;
+    constexpr size_t kMaxLiteralRun = 112;
+    // The optimal parse runs over blocks of this many bytes to keep its tables small.
+    constexpr size_t kOptimalBlockSize = 32 * 1024;
+
+    struct LevelParams {
+        size_t chainDepth;
+        size_t niceLength; // stop searching once a match is at least this long
+        bool lazy;
+        bool optimal;
+    };
+
+    LevelParams ParamsFor(const QFS::Compressor::Level level) {
+        switch (level) {
+        case QFS::Compressor::Level::kFast:
+            return {4, 32, false, false};
+        case QFS::Compressor::Level::kOptimal:
+            return {32, 128, false, true};
+        case QFS::Compressor::Level::kDefault:
+        default:
+            return {32, 128, true, false};
+        }
+    }
+
+    // Shorter forms only reach nearby offsets, so distant matches must be long enough for the larger forms.
+    size_t MinMatchForOffset(const size_t offset) {
+        if (offset <= 1024) {
+            return 3;
+        }
+        if (offset <= 16384) {
+            return 4;
+        }
+        return 5;
+    }
+
+    // Bytes taken by the control block that encodes this copy.
+    uint32_t MatchCost(const size_t length, const size_t offset) {
+        if (length <= 10 && offset <= 1024) {
+            return 2;
+        }
+        if (length <= 67 && offset <= 16384) {
+            return 3;
+        }
+        return 4;
+    }
+
+    struct Match {
+        size_t length = 0;
+        size_t offset = 0;
+    };
+
+    class MatchFinder {
+    public:
+        MatchFinder(const uint8_t* data, const size_t size)
+            : mData(data)
+            , mSize(size)
+            // Tables sized to the input so small entries do not pay for a full window.
+            , mHashBits(std::clamp(static_cast<int>(std::bit_width(size)), 8, 16))
+            , mChainMask(std::min(kWindowSize, std::bit_ceil(std::max<size_t>(size, 1))) - 1)
+            , mHead(size_t{1} << mHashBits, -1)
+            , mChain(mChainMask + 1, -1) {}
+
+        void Insert(const size_t pos) {
+            if (pos + kMinMatch > mSize) {
+                return;
+            }
+            const uint32_t hash = Hash(pos);
+            mChain[pos & mChainMask] = mHead[hash];
+            mHead[hash] = static_cast<int32_t>(pos);
+        }
+
+        // Calls visit(match) for each candidate that is longer than every earlier one, nearest first.
+        template <typename Visit>
+        void ForEachMatch(const size_t pos, const size_t maxLength, const LevelParams& params, Visit&& visit) const {
+            if (pos + kMinMatch > mSize) {
+                return;
+            }
+            size_t bestLength = 0;
+            int32_t candidate = mHead[Hash(pos)];
+            for (size_t depth = 0; candidate >= 0 && depth < params.chainDepth; ++depth) {
+                const size_t offset = pos - static_cast<size_t>(candidate);
+                if (offset > kWindowSize) {
+                    break;
+                }
+                const uint8_t* match = mData + candidate;
+                const uint8_t* current = mData + pos;
+                if (bestLength == 0 || match[bestLength] == current[bestLength]) {
+                    size_t length = 0;
+                    while (length < maxLength && match[length] == current[length]) {
+                        ++length;
+                    }
+                    if (length > bestLength && length >= MinMatchForOffset(offset)) {
+                        bestLength = length;
+                        visit(Match{length, offset});
+                        if (length >= params.niceLength || length == maxLength) {
+                            break;
+                        }
+                    }
+                }
+                const int32_t next = mChain[static_cast<size_t>(candidate) & mChainMask];
+                if (next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+        }
+
+        [[nodiscard]] Match FindBest(const size_t pos, const LevelParams& params) const {
+            Match best;
+            ForEachMatch(pos, std::min(kMaxMatch, mSize - pos), params, [&](const Match& match) { best = match; });
+            return best;
+        }
+
+    private:
+        [[nodiscard]] uint32_t Hash(const size_t pos) const {
+            const uint8_t* p = mData + pos;
+            const uint32_t value = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) |
+                                   static_cast<uint32_t>(p[2]);
+            return (value * 2654435761u) >> (32 - mHashBits);
+        }
+
+        const uint8_t* mData;
+        size_t mSize;
+        int mHashBits;
+        size_t mChainMask;
+        std::vector<int32_t> mHead;
+        std::vector<int32_t> mChain;
+    };
+
+    class Emitter {
+    public:
+        Emitter(const uint8_t* data, const size_t size, std::vector<uint8_t>& out)
+            : mData(data)
+            , mSize(size)
+            , mOut(out) {}
+
+        void Copy(const size_t pos, const Match& match) {
+            const size_t pending = EmitLiterals(pos - mLiteralStart);
+            const size_t o = match.offset - 1;
+            const size_t length = match.length;
+            if (length <= 10 && match.offset <= 1024) {
+                mOut.push_back(static_cast<uint8_t>(((o >> 3) & 0x60) | ((length - 3) << 2) | pending));
+                mOut.push_back(static_cast<uint8_t>(o & 0xFF));
+            } else if (length <= 67 && match.offset <= 16384) {
+                mOut.push_back(static_cast<uint8_t>(0x80 | (length - 4)));
+                mOut.push_back(static_cast<uint8_t>((pending << 6) | (o >> 8)));
+                mOut.push_back(static_cast<uint8_t>(o & 0xFF));
+            } else {
+                const size_t l = length - 5;
+                mOut.push_back(static_cast<uint8_t>(0xC0 | ((o >> 12) & 0x10) | ((l >> 6) & 0x0C) | pending));
+                mOut.push_back(static_cast<uint8_t>((o >> 8) & 0xFF));
+                mOut.push_back(static_cast<uint8_t>(o & 0xFF));
+                mOut.push_back(static_cast<uint8_t>(l & 0xFF));
+            }
+            mOut.insert(mOut.end(), mData + pos - pending, mData + pos);
+            mLiteralStart = pos + length;
+        }
+
+        void Finish() {
+            const size_t remaining = EmitLiterals(mSize - mLiteralStart);
+            mOut.push_back(static_cast<uint8_t>(0xFC | remaining));
+            mOut.insert(mOut.end(), mData + mSize - remaining, mData + mSize);
+        }
+
+    private:
+        // Emits literal blocks for all but the last (count % 4) bytes, which the next control block carries.
+        size_t EmitLiterals(size_t count) {
+            const uint8_t* literals = mData + mLiteralStart;
+            while (count >= 4) {
+                const size_t chunk = std::min(kMaxLiteralRun, count & ~size_t{3});
+                mOut.push_back(static_cast<uint8_t>(0xE0 | ((chunk - 4) >> 2)));
+                mOut.insert(mOut.end(), literals, literals + chunk);
+                literals += chunk;
+                count -= chunk;
+                mLiteralStart += chunk;
+            }
+            return count;
+        }
+
+        const uint8_t* mData;
+        size_t mSize;
+        std::vector<uint8_t>& mOut;
+        size_t mLiteralStart = 0;
+    };
+
+    void CompressGreedy(const uint8_t* data, const size_t size, const LevelParams& params, Emitter& emitter) {
+        MatchFinder finder(data, size);
+        size_t pos = 0;
+        while (pos + kMinMatch <= size) {
+            Match match = finder.FindBest(pos, params);
+            finder.Insert(pos);
+            if (match.length == 0) {
+                ++pos;
+                continue;
+            }
+
+            // Lazy matching: if the next position has a longer match, emit a literal instead.
+            while (params.lazy && match.length < params.niceLength && pos + 1 + kMinMatch <= size) {
+                const Match next = finder.FindBest(pos + 1, params);
+                if (next.length <= match.length) {
+                    break;
+                }
+                ++pos;
+                finder.Insert(pos);
+                match = next;
+            }
+
+            emitter.Copy(pos, match);
+            for (size_t i = 1; i < match.length; ++i) {
+                finder.Insert(pos + i);
+            }
+            pos += match.length;
+        }
+        emitter.Finish();
+    }
+
+    // Shortest-path parse per block: price[i] is the cheapest encoding of the block's first i bytes, counting a
+    // literal as one byte and a copy as its control block.
+    void CompressOptimal(const uint8_t* data, const size_t size, const LevelParams& params, Emitter& emitter) {
+        constexpr uint32_t kUnreached = std::numeric_limits<uint32_t>::max();
+        MatchFinder finder(data, size);
+        std::vector<uint32_t> price(kOptimalBlockSize + 1);
+        std::vector<Match> step(kOptimalBlockSize + 1);
+        std::vector<Match> path;
+
+        for (size_t blockStart = 0; blockStart < size; blockStart += kOptimalBlockSize) {
+            const size_t blockSize = std::min(kOptimalBlockSize, size - blockStart);
+            std::fill(price.begin(), price.begin() + blockSize + 1, kUnreached);
+            price[0] = 0;
+
+            for (size_t i = 0; i < blockSize; ++i) {
+                const size_t pos = blockStart + i;
+                if (price[i] == kUnreached) {
+                    finder.Insert(pos);
+                    continue;
+                }
+                if (price[i] + 1 < price[i + 1]) {
+                    price[i + 1] = price[i] + 1;
+                    step[i + 1] = Match{};
+                }
+
+                // Copies stay inside the block so the table only covers the block.
+                const size_t maxLength = std::min(kMaxMatch, blockSize - i);
+                size_t longest = 0;
+                finder.ForEachMatch(pos, maxLength, params, [&](const Match& match) {
+                    // Candidates arrive with increasing length, so each one only relaxes the lengths that no
+                    // nearer (and therefore cheaper or equal) candidate could reach.
+                    const size_t first = std::max(MinMatchForOffset(match.offset), longest + 1);
+                    for (size_t length = first; length <= match.length; ++length) {
+                        const uint32_t cost = price[i] + MatchCost(length, match.offset);
+                        if (cost < price[i + length]) {
+                            price[i + length] = cost;
+                            step[i + length] = Match{length, match.offset};
+                        }
+                    }
+                    longest = std::max(longest, match.length);
+                });
+                finder.Insert(pos);
+
+                // A very long copy is taken as is; parsing inside it would cost time for no gain.
+                if (longest >= params.niceLength) {
+                    for (size_t j = 1; j < longest; ++j) {
+                        finder.Insert(pos + j);
+                    }
+                    i += longest - 1;
+                }
+            }
+
+            path.clear();
+            for (size_t i = blockSize; i > 0;) {
+                const Match& match = step[i];
+                path.push_back(match);
+                i -= match.length == 0 ? 1 : match.length;
+            }
+
+            size_t pos = blockStart;
+            for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                if (it->length == 0) {
+                    ++pos;
+                    continue;
+                }
+                emitter.Copy(pos, *it);
+                pos += it->length;
+            }
+        }
+        emitter.Finish();
+    }
+
+} // namespace
+
+namespace QFS {
+
+    ParseExpected<std::vector<uint8_t>> Compressor::Compress(std::span<const uint8_t> input, const Level level) {
+        if (input.size() > kMaxInputSize) {
+            return Fail("QFS input too large ({} bytes, limit {})", input.size(), kMaxInputSize);
+        }
+
+        const uint8_t* data = input.data();
+        const size_t size = input.size();
+
+        std::vector<uint8_t> out;
+        out.reserve(size / 2 + 16);
+        out.push_back(static_cast<uint8_t>(MAGIC_COMPRESSED >> 8));
+        out.push_back(static_cast<uint8_t>(MAGIC_COMPRESSED & 0xFF));
+        out.push_back(static_cast<uint8_t>(size >> 16));
+        out.push_back(static_cast<uint8_t>(size >> 8));
+        out.push_back(static_cast<uint8_t>(size));
+
+        const LevelParams params = ParamsFor(level);
+        Emitter emitter(data, size, out);
+        if (params.optimal) {
+            CompressOptimal(data, size, params, emitter);
+        } else {
+            CompressGreedy(data, size, params, emitter);
+        }
+        return out;
+    }
+
+    std::vector<ParseExpected<std::vector<uint8_t>>> Compressor::CompressBatch(
+        std::span<const std::span<const uint8_t>> inputs, const Level level, DBPF::ThreadPool* pool) {
+        std::vector<std::optional<ParseExpected<std::vector<uint8_t>>>> slots(inputs.size());
+        auto& workers = pool ? *pool : DBPF::ThreadPool::Shared();
+        workers.ParallelFor(inputs.size(), [&](const size_t i) {
+            slots[i].emplace(Compress(inputs[i], level));
+        });
+
+        std::vector<ParseExpected<std::vector<uint8_t>>> results;
+        results.reserve(slots.size());
+        for (auto& slot : slots) {
+            results.push_back(std::move(*slot));
+        }
+        return results;
+    }
+
+} // namespace QFS
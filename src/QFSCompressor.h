@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ParseTypes.h"
+
+namespace DBPF { class ThreadPool; }
+
+namespace QFS {
+
+    // Produces streams that Decompressor reads back: the 5-byte 10 FB header followed by control blocks in all
+    // four forms (short, medium and long copies, literal runs) and the terminator.
+    class Compressor {
+    public:
+        // The header stores the uncompressed size in 24 bits.
+        static constexpr size_t kMaxInputSize = 0xFFFFFF;
+
+        enum class Level {
+            kFast,     // greedy, shallow hash chains
+            kDefault,  // lazy matching, deeper chains
+            kOptimal   // price-based optimal parse over each block
+        };
+
+        static ParseExpected<std::vector<uint8_t>> Compress(std::span<const uint8_t> input,
+                                                            Level level = Level::kDefault);
+        // Compresses every input on the pool (ThreadPool::Shared() when null); results are in input order.
+        static std::vector<ParseExpected<std::vector<uint8_t>>> CompressBatch(
+            std::span<const std::span<const uint8_t>> inputs, Level level = Level::kDefault,
+            DBPF::ThreadPool* pool = nullptr);
+    };
+
+} // namespace QFS
@@ -1,6 +1,9 @@
 #include "QFSDecompressor.h"
 
 #include <cstring>
+
+#include "Trace.h"
+
 namespace {
 
     inline uint32_t Read24BE(const uint8_t* data) {
@@ -16,47 +19,133 @@ namespace {
         std::memcpy(dest, src, len);
     }
 
-    ParseExpected<void> OffsetCopy(uint8_t* buffer, int destPos, int offset, int len) {
-        if (offset <= 0 || offset > destPos) {
+    ParseExpected<void> OffsetCopy(uint8_t* buffer, size_t destPos, size_t offset, size_t len) {
+        if (offset == 0 || offset > destPos) {
             return Fail("Invalid QFS offset {} at dest {}", offset, destPos);
         }
-        int srcPos = destPos - offset;
-        for (int i = 0; i < len; ++i) {
+        const size_t srcPos = destPos - offset;
+        for (size_t i = 0; i < len; ++i) {
             buffer[destPos + i] = buffer[srcPos + i];
         }
         return {};
     }
 
+    // The fast loop may read and write up to kWideOverrun bytes past the end of an operation, so it only runs
+    // while every operation is guaranteed to fit with that much room to spare. The largest operation consumes a
+    // control byte plus 112 literal bytes, and produces 3 literal bytes plus a 1028 byte copy.
+    constexpr size_t kWideOverrun = 32;
+    constexpr size_t kInputMargin = 1 + 112 + kWideOverrun;
+    constexpr size_t kOutputMargin = 3 + 1028 + kWideOverrun;
+
+    // Copies len bytes in 16 byte chunks, writing up to 15 bytes past the end.
+    inline void CopyLiteralWide(const uint8_t* src, uint8_t* dest, size_t len) {
+        std::memcpy(dest, src, 16);
+        for (size_t i = 16; i < len; i += 16) {
+            std::memcpy(dest + i, src + i, 16);
+        }
+    }
+
+    // Copies a back-reference of len bytes at the given distance, writing up to 31 bytes past the end. Chunks
+    // never overlap their own source, and distances shorter than 8 bytes replicate the repeating pattern.
+    inline void OffsetCopyWide(uint8_t* dest, size_t offset, size_t len) {
+        const uint8_t* src = dest - offset;
+        uint8_t* const end = dest + len;
+        if (offset >= 32) {
+            do {
+                std::memcpy(dest, src, 32);
+                dest += 32;
+                src += 32;
+            } while (dest < end);
+        } else if (offset >= 16) {
+            do {
+                std::memcpy(dest, src, 16);
+                dest += 16;
+                src += 16;
+            } while (dest < end);
+        } else if (offset >= 8) {
+            do {
+                std::memcpy(dest, src, 8);
+                dest += 8;
+                src += 8;
+            } while (dest < end);
+        } else {
+            uint8_t pattern[8];
+            for (size_t i = 0; i < 8; ++i) {
+                pattern[i] = src[i % offset];
+            }
+            // Advancing by a whole number of periods keeps every store aligned with the pattern.
+            const size_t step = 8 - 8 % offset;
+            do {
+                std::memcpy(dest, pattern, 8);
+                dest += step;
+            } while (dest < end);
+        }
+    }
+
 } // namespace
 
 namespace QFS {
 
-    ParseExpected<size_t> Decompressor::Decompress(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    ParseExpected<uint32_t> Decompressor::ValidateHeader(std::span<const uint8_t> input) {
         if (input.size() < 5) {
             return Fail("QFS payload too small ({} bytes)", input.size());
         }
 
         const uint8_t* data = input.data();
-        const size_t size = input.size();
-
         const uint16_t magic = static_cast<uint16_t>((static_cast<uint16_t>(data[0] & 0xFE) << 8) | data[1]);
         if (magic != MAGIC_COMPRESSED) {
             return Fail("QFS magic mismatch: expected 0x{:04X}, got 0x{:04X}", MAGIC_COMPRESSED, magic);
         }
+        return Read24BE(data);
+    }
+
+    template <typename Vector>
+    ParseExpected<size_t> Decompressor::DecompressToVector(std::span<const uint8_t> input, Vector& output) {
+        const auto uncompressedSize = ValidateHeader(input);
+        if (!uncompressedSize.has_value()) {
+            return std::unexpected(uncompressedSize.error());
+        }
 
-        const uint32_t uncompressedSize = Read24BE(data);
-        output.assign(uncompressedSize, 0);
-        if (uncompressedSize == 0) {
+        output.assign(*uncompressedSize, 0);
+        if (*uncompressedSize == 0) {
             return static_cast<size_t>(0);
         }
 
-        auto result = DecompressInternal(data, size, output.data(), uncompressedSize);
+        auto result = DecompressInternal(input.data(), input.size(), output.data(), *uncompressedSize);
         if (!result.has_value()) {
             output.clear();
             return std::unexpected(result.error());
         }
 
-        return static_cast<size_t>(uncompressedSize);
+        return static_cast<size_t>(*uncompressedSize);
+    }
+
+    ParseExpected<size_t> Decompressor::Decompress(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+        return DecompressToVector(input, output);
+    }
+
+    ParseExpected<size_t> Decompressor::Decompress(std::span<const uint8_t> input,
+                                                   std::pmr::vector<uint8_t>& output) {
+        return DecompressToVector(input, output);
+    }
+
+    ParseExpected<size_t> Decompressor::Decompress(std::span<const uint8_t> input, std::span<uint8_t> output) {
+        const auto uncompressedSize = ValidateHeader(input);
+        if (!uncompressedSize.has_value()) {
+            return std::unexpected(uncompressedSize.error());
+        }
+        if (output.size() < *uncompressedSize) {
+            return Fail("QFS output buffer too small: need {} bytes, have {}", *uncompressedSize, output.size());
+        }
+        if (*uncompressedSize == 0) {
+            return static_cast<size_t>(0);
+        }
+
+        auto result = DecompressInternal(input.data(), input.size(), output.data(), *uncompressedSize);
+        if (!result.has_value()) {
+            return std::unexpected(result.error());
+        }
+        return static_cast<size_t>(*uncompressedSize);
     }
 
     bool Decompressor::IsQFSCompressed(std::span<const uint8_t> buffer) {
@@ -76,35 +165,77 @@ namespace QFS {
 
     ParseExpected<void> Decompressor::DecompressInternal(const uint8_t* input, size_t inputSize,
                                                          uint8_t* output, size_t outputSize) {
-        int inPos = (input[0] & 0x01) ? 8 : 5;
-        int outPos = 0;
-        int control1 = 0;
+        DBPFKIT_TRACE_SCOPE_BYTES("qfs", "QFS::Decompress", outputSize);
+        size_t inPos = (input[0] & 0x01) ? 8 : 5;
+        size_t outPos = 0;
 
-        while (inPos < static_cast<int>(inputSize) && control1 < 0xFC) {
-            if (inPos >= static_cast<int>(inputSize)) {
-                return Fail("QFS truncated while reading control byte");
+        // Fast path: the margins cover the largest possible operation, so only the back-reference distance
+        // needs checking.
+        while (inPos + kInputMargin <= inputSize && outPos + kOutputMargin <= outputSize) {
+            const uint8_t* in = input + inPos;
+            const uint32_t control1 = in[0];
+            size_t literalLen = 0;
+            size_t offset = 0;
+            size_t copyLen = 0;
+            if (control1 <= 0x7F) {
+                literalLen = control1 & 0x03;
+                offset = ((control1 & 0x60) << 3) + in[1] + 1;
+                copyLen = ((control1 & 0x1C) >> 2) + 3;
+                inPos += 2;
+            } else if (control1 <= 0xBF) {
+                literalLen = (in[1] >> 6) & 0x03;
+                offset = ((in[1] & 0x3F) << 8) + in[2] + 1;
+                copyLen = (control1 & 0x3F) + 4;
+                inPos += 3;
+            } else if (control1 <= 0xDF) {
+                literalLen = control1 & 0x03;
+                offset = ((control1 & 0x10) << 12) + (in[1] << 8) + in[2] + 1;
+                copyLen = ((control1 & 0x0C) << 6) + in[3] + 5;
+                inPos += 4;
+            } else if (control1 <= 0xFB) {
+                literalLen = ((control1 & 0x1F) << 2) + 4;
+                CopyLiteralWide(input + inPos + 1, output + outPos, literalLen);
+                inPos += 1 + literalLen;
+                outPos += literalLen;
+                continue;
+            } else {
+                break; // the checked loop handles the terminator
+            }
+
+            // At most 3 literal bytes, copied as one 4 byte block.
+            std::memcpy(output + outPos, input + inPos, 4);
+            inPos += literalLen;
+            outPos += literalLen;
+            if (offset > outPos) {
+                return Fail("Invalid QFS offset {} at dest {}", offset, outPos);
             }
-            control1 = input[inPos++] & 0xFF;
+            OffsetCopyWide(output + outPos, offset, copyLen);
+            outPos += copyLen;
+        }
+
+        uint32_t control1 = 0;
+        while (inPos < inputSize && control1 < 0xFC) {
+            control1 = input[inPos++];
 
             if (control1 <= 0x7F) {
-                if (inPos >= static_cast<int>(inputSize)) {
+                if (inPos >= inputSize) {
                     return Fail("QFS truncated in control1<=0x7F block");
                 }
-                int control2 = input[inPos++] & 0xFF;
-                int literalLen = control1 & 0x03;
-                if (inPos + literalLen > static_cast<int>(inputSize)) {
+                const uint32_t control2 = input[inPos++];
+                const size_t literalLen = control1 & 0x03;
+                if (inPos + literalLen > inputSize) {
                     return Fail("QFS literal overruns input (short block)");
                 }
-                if (outPos + literalLen > static_cast<int>(outputSize)) {
+                if (outPos + literalLen > outputSize) {
                     return Fail("QFS literal overruns output (short block)");
                 }
                 CopyLiteral(input + inPos, output + outPos, literalLen);
                 outPos += literalLen;
                 inPos += literalLen;
 
-                int offset = ((control1 & 0x60) << 3) + control2 + 1;
-                int copyLen = ((control1 & 0x1C) >> 2) + 3;
-                if (outPos + copyLen > static_cast<int>(outputSize)) {
+                const size_t offset = ((control1 & 0x60) << 3) + control2 + 1;
+                const size_t copyLen = ((control1 & 0x1C) >> 2) + 3;
+                if (outPos + copyLen > outputSize) {
                     return Fail("QFS copy overruns output (short block)");
                 }
                 if (auto status = OffsetCopy(output, outPos, offset, copyLen); !status.has_value()) {
@@ -112,26 +243,26 @@ namespace QFS {
                 }
                 outPos += copyLen;
             } else if (control1 <= 0xBF) {
-                if (inPos + 1 >= static_cast<int>(inputSize)) {
+                if (inPos + 1 >= inputSize) {
                     return Fail("QFS truncated in control1<=0xBF block");
                 }
-                int control2 = input[inPos++] & 0xFF;
-                int control3 = input[inPos++] & 0xFF;
+                const uint32_t control2 = input[inPos++];
+                const uint32_t control3 = input[inPos++];
 
-                int literalLen = (control2 >> 6) & 0x03;
-                if (inPos + literalLen > static_cast<int>(inputSize)) {
+                const size_t literalLen = (control2 >> 6) & 0x03;
+                if (inPos + literalLen > inputSize) {
                     return Fail("QFS literal overruns input (mid block)");
                 }
-                if (outPos + literalLen > static_cast<int>(outputSize)) {
+                if (outPos + literalLen > outputSize) {
                     return Fail("QFS literal overruns output (mid block)");
                 }
                 CopyLiteral(input + inPos, output + outPos, literalLen);
                 outPos += literalLen;
                 inPos += literalLen;
 
-                int offset = ((control2 & 0x3F) << 8) + control3 + 1;
-                int copyLen = (control1 & 0x3F) + 4;
-                if (outPos + copyLen > static_cast<int>(outputSize)) {
+                const size_t offset = ((control2 & 0x3F) << 8) + control3 + 1;
+                const size_t copyLen = (control1 & 0x3F) + 4;
+                if (outPos + copyLen > outputSize) {
                     return Fail("QFS copy overruns output (mid block)");
                 }
                 if (auto status = OffsetCopy(output, outPos, offset, copyLen); !status.has_value()) {
@@ -139,27 +270,27 @@ namespace QFS {
                 }
                 outPos += copyLen;
             } else if (control1 <= 0xDF) {
-                if (inPos + 2 >= static_cast<int>(inputSize)) {
+                if (inPos + 2 >= inputSize) {
                     return Fail("QFS truncated in control1<=0xDF block");
                 }
-                int control2 = input[inPos++] & 0xFF;
-                int control3 = input[inPos++] & 0xFF;
-                int control4 = input[inPos++] & 0xFF;
+                const uint32_t control2 = input[inPos++];
+                const uint32_t control3 = input[inPos++];
+                const uint32_t control4 = input[inPos++];
 
-                int literalLen = control1 & 0x03;
-                if (inPos + literalLen > static_cast<int>(inputSize)) {
+                const size_t literalLen = control1 & 0x03;
+                if (inPos + literalLen > inputSize) {
                     return Fail("QFS literal overruns input (long block)");
                 }
-                if (outPos + literalLen > static_cast<int>(outputSize)) {
+                if (outPos + literalLen > outputSize) {
                     return Fail("QFS literal overruns output (long block)");
                 }
                 CopyLiteral(input + inPos, output + outPos, literalLen);
                 outPos += literalLen;
                 inPos += literalLen;
 
-                int offset = ((control1 & 0x10) << 12) + (control2 << 8) + control3 + 1;
-                int copyLen = ((control1 & 0x0C) << 6) + control4 + 5;
-                if (outPos + copyLen > static_cast<int>(outputSize)) {
+                const size_t offset = ((control1 & 0x10) << 12) + (control2 << 8) + control3 + 1;
+                const size_t copyLen = ((control1 & 0x0C) << 6) + control4 + 5;
+                if (outPos + copyLen > outputSize) {
                     return Fail("QFS copy overruns output (long block)");
                 }
                 if (auto status = OffsetCopy(output, outPos, offset, copyLen); !status.has_value()) {
@@ -167,22 +298,22 @@ namespace QFS {
                 }
                 outPos += copyLen;
             } else if (control1 <= 0xFB) {
-                int literalLen = ((control1 & 0x1F) << 2) + 4;
-                if (inPos + literalLen > static_cast<int>(inputSize)) {
+                const size_t literalLen = ((control1 & 0x1F) << 2) + 4;
+                if (inPos + literalLen > inputSize) {
                     return Fail("QFS literal overruns input (raw block)");
                 }
-                if (outPos + literalLen > static_cast<int>(outputSize)) {
+                if (outPos + literalLen > outputSize) {
                     return Fail("QFS literal overruns output (raw block)");
                 }
                 CopyLiteral(input + inPos, output + outPos, literalLen);
                 outPos += literalLen;
                 inPos += literalLen;
             } else {
-                int literalLen = control1 & 0x03;
-                if (inPos + literalLen > static_cast<int>(inputSize)) {
+                const size_t literalLen = control1 & 0x03;
+                if (inPos + literalLen > inputSize) {
                     return Fail("QFS literal overruns input (terminator block)");
                 }
-                if (outPos + literalLen > static_cast<int>(outputSize)) {
+                if (outPos + literalLen > outputSize) {
                     return Fail("QFS literal overruns output (terminator block)");
                 }
                 CopyLiteral(input + inPos, output + outPos, literalLen);
@@ -192,7 +323,7 @@ namespace QFS {
             }
         }
 
-        if (static_cast<size_t>(outPos) != outputSize) {
+        if (outPos != outputSize) {
             return Fail("QFS decompression wrote {} bytes but expected {}", outPos, outputSize);
         }
         return {};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <span>
 #include <vector>
 
@@ -16,10 +17,16 @@ namespace QFS {
     class Decompressor {
     public:
         static ParseExpected<size_t> Decompress(std::span<const uint8_t> input, std::vector<uint8_t>& output);
+        static ParseExpected<size_t> Decompress(std::span<const uint8_t> input, std::pmr::vector<uint8_t>& output);
+        // Decompresses into caller-owned storage, which must hold at least GetUncompressedSize(input) bytes.
+        static ParseExpected<size_t> Decompress(std::span<const uint8_t> input, std::span<uint8_t> output);
         static bool IsQFSCompressed(std::span<const uint8_t> buffer);
         static uint32_t GetUncompressedSize(std::span<const uint8_t> buffer);
 
     private:
+        template <typename Vector>
+        static ParseExpected<size_t> DecompressToVector(std::span<const uint8_t> input, Vector& output);
+        static ParseExpected<uint32_t> ValidateHeader(std::span<const uint8_t> input);
         static ParseExpected<void> DecompressInternal(const uint8_t* input, size_t inputSize,
                                                       uint8_t* output, size_t outputSize);
     };
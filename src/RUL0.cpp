@@ -8,6 +8,7 @@
 #include <ranges>
 
 #include "ParseTypes.h"
+#include "Trace.h"
 #include "ini.h"
 
 namespace RUL0::ParseHelpers {
@@ -947,6 +948,7 @@ namespace RUL0 {
     }
 
     ParseExpected<Record> Parse(const std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE_BYTES("parse", "RUL0::Parse", buffer.size());
         Record data;
         const auto text = reinterpret_cast<const char*>(buffer.data());
         const int parseResult = ini_parse_string_length(text, buffer.size(), IniHandler, &data);
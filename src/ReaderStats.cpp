@@ -0,0 +1,39 @@
+#include "ReaderStats.h"
+
+namespace DBPF {
+
+    template <typename Stats, typename Read>
+    ReaderStats::Snapshot ReaderStats::Collect(Stats& stats, Read&& read) {
+        Snapshot snapshot;
+        snapshot.bytesMapped = read(stats.mBytesMapped);
+        snapshot.bytesReadFallback = read(stats.mBytesReadFallback);
+        snapshot.entriesDecompressed = read(stats.mEntriesDecompressed);
+        snapshot.qfsBytesIn = read(stats.mQfsBytesIn);
+        snapshot.qfsBytesOut = read(stats.mQfsBytesOut);
+        snapshot.readFailures = read(stats.mReadFailures);
+        snapshot.decompressFailures = read(stats.mDecompressFailures);
+        for (size_t i = 0; i < kParserCount; ++i) {
+            snapshot.parsers[i].calls = read(stats.mParsers[i].calls);
+            snapshot.parsers[i].failures = read(stats.mParsers[i].failures);
+            snapshot.parsers[i].nanoseconds = read(stats.mParsers[i].nanoseconds);
+        }
+        return snapshot;
+    }
+
+    ReaderStats::Snapshot ReaderStats::GetSnapshot() const {
+        return Collect(*this, [](const std::atomic<uint64_t>& counter) {
+            return counter.load(std::memory_order_relaxed);
+        });
+    }
+
+    ReaderStats::Snapshot ReaderStats::TakeSnapshot() {
+        return Collect(*this, [](std::atomic<uint64_t>& counter) {
+            return counter.exchange(0, std::memory_order_relaxed);
+        });
+    }
+
+    void ReaderStats::Reset() {
+        TakeSnapshot();
+    }
+
+} // namespace DBPF
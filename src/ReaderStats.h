@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DBPF {
+
+    // I/O and decode counters of a Reader. Every counter is a relaxed atomic, so recording costs a few
+    // uncontended increments and can stay on in production; a snapshot taken during concurrent reads may mix
+    // counts from just before and just after an operation.
+    class ReaderStats {
+    public:
+        // One per typed loader; the Tgi, mask and label overloads are counted under the entry they resolve to.
+        enum class Parser {
+            kFSH,
+            kS3D,
+            kExemplar,
+            kLText,
+            kRUL0
+        };
+        static constexpr size_t kParserCount = 5;
+
+        struct ParserCounts {
+            uint64_t calls = 0;
+            uint64_t failures = 0;
+            // Wall time inside the loader, including reading and decompressing the entry.
+            uint64_t nanoseconds = 0;
+        };
+
+        struct Snapshot {
+            // Header, index and entry bytes served from a memory mapping.
+            uint64_t bytesMapped = 0;
+            // Bytes copied in with positional reads, because mapping was disabled or refused or a streaming scan
+            // read through its window.
+            uint64_t bytesReadFallback = 0;
+            uint64_t entriesDecompressed = 0;
+            uint64_t qfsBytesIn = 0;
+            uint64_t qfsBytesOut = 0;
+            uint64_t readFailures = 0;
+            uint64_t decompressFailures = 0;
+            std::array<ParserCounts, kParserCount> parsers{};
+
+            [[nodiscard]] const ParserCounts& Get(const Parser parser) const {
+                return parsers[static_cast<size_t>(parser)];
+            }
+        };
+
+        ReaderStats() = default;
+        ReaderStats(const ReaderStats&) = delete;
+        ReaderStats& operator=(const ReaderStats&) = delete;
+
+        [[nodiscard]] Snapshot GetSnapshot() const;
+        // Returns the counts and zeroes them counter by counter, so no increment is lost between the two, e.g.
+        // when exporting deltas as metrics.
+        Snapshot TakeSnapshot();
+        void Reset();
+
+        void RecordMapped(const uint64_t bytes) { Add(mBytesMapped, bytes); }
+        void RecordFallbackRead(const uint64_t bytes) { Add(mBytesReadFallback, bytes); }
+        void RecordReadFailure() { Add(mReadFailures, 1); }
+        void RecordDecompressed(const uint64_t bytesIn, const uint64_t bytesOut) {
+            Add(mEntriesDecompressed, 1);
+            Add(mQfsBytesIn, bytesIn);
+            Add(mQfsBytesOut, bytesOut);
+        }
+        void RecordDecompressFailure() { Add(mDecompressFailures, 1); }
+        void RecordParse(const Parser parser, const bool succeeded, const uint64_t nanoseconds) {
+            auto& counters = mParsers[static_cast<size_t>(parser)];
+            Add(counters.calls, 1);
+            Add(counters.nanoseconds, nanoseconds);
+            if (!succeeded) {
+                Add(counters.failures, 1);
+            }
+        }
+
+    private:
+        struct ParserCounters {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> failures{0};
+            std::atomic<uint64_t> nanoseconds{0};
+        };
+
+        // Shared by the const and the resetting snapshot.
+        template <typename Stats, typename Read>
+        static Snapshot Collect(Stats& stats, Read&& read);
+        static void Add(std::atomic<uint64_t>& counter, const uint64_t value) {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> mBytesMapped{0};
+        std::atomic<uint64_t> mBytesReadFallback{0};
+        std::atomic<uint64_t> mEntriesDecompressed{0};
+        std::atomic<uint64_t> mQfsBytesIn{0};
+        std::atomic<uint64_t> mQfsBytesOut{0};
+        std::atomic<uint64_t> mReadFailures{0};
+        std::atomic<uint64_t> mDecompressFailures{0};
+        std::array<ParserCounters, kParserCount> mParsers{};
+    };
+
+} // namespace DBPF
@@ -0,0 +1,230 @@
+#include "RecordCache.h"
+
+#include <exception>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "ExemplarReader.h"
+#include "FSHReader.h"
+#include "LTextReader.h"
+#include "PluginSet.h"
+#include "S3DReader.h"
+
+namespace {
+
+    template <typename T>
+    size_t VectorBytes(const std::vector<T>& values) {
+        return values.capacity() * sizeof(T);
+    }
+
+    // Heap bytes of a string; short strings live inside the object.
+    template <typename Char>
+    size_t StringBytes(const std::basic_string<Char>& text) {
+        return text.capacity() > std::basic_string<Char>().capacity() ? (text.capacity() + 1) * sizeof(Char) : 0;
+    }
+
+    size_t EstimateBytes(const Exemplar::Record& record) {
+        size_t bytes = sizeof(record) + VectorBytes(record.properties);
+        for (const auto& property : record.properties) {
+            bytes += VectorBytes(property.values);
+            for (const auto& value : property.values) {
+                if (const auto* text = std::get_if<std::string>(&value)) {
+                    bytes += StringBytes(*text);
+                }
+            }
+        }
+        return bytes;
+    }
+
+    size_t EstimateBytes(const FSH::Record& record) {
+        size_t bytes = sizeof(record) + VectorBytes(record.entries);
+        for (const auto& entry : record.entries) {
+            bytes += StringBytes(entry.name) + StringBytes(entry.label) + VectorBytes(entry.bitmaps);
+            for (const auto& bitmap : entry.bitmaps) {
+                bytes += VectorBytes(bitmap.data);
+            }
+        }
+        return bytes;
+    }
+
+    size_t EstimateBytes(const S3D::Record& record) {
+        size_t bytes = sizeof(record) + VectorBytes(record.vertexBuffers) + VectorBytes(record.indexBuffers) +
+                       VectorBytes(record.primitiveBlocks) + VectorBytes(record.materials) +
+                       VectorBytes(record.animation.animatedMeshes);
+        for (const auto& buffer : record.vertexBuffers) {
+            bytes += VectorBytes(buffer.vertices);
+        }
+        for (const auto& buffer : record.indexBuffers) {
+            bytes += VectorBytes(buffer.indices);
+        }
+        for (const auto& block : record.primitiveBlocks) {
+            bytes += VectorBytes(block);
+        }
+        for (const auto& material : record.materials) {
+            bytes += VectorBytes(material.textures);
+            for (const auto& texture : material.textures) {
+                bytes += StringBytes(texture.animName);
+            }
+        }
+        for (const auto& mesh : record.animation.animatedMeshes) {
+            bytes += StringBytes(mesh.name) + VectorBytes(mesh.frames);
+        }
+        return bytes;
+    }
+
+    size_t EstimateBytes(const LText::Record& record) {
+        return sizeof(record) + StringBytes(record.text);
+    }
+
+} // namespace
+
+namespace DBPF {
+
+    RecordCache::RecordCache(Source source)
+        : mSource(std::move(source)) {}
+
+    RecordCache::RecordCache(const Reader& reader)
+        : mSource([&reader](const Tgi& tgi) { return reader.ReadEntryView(tgi); }) {}
+
+    RecordCache::RecordCache(const PluginSet& plugins)
+        : mSource([&plugins](const Tgi& tgi) { return plugins.ReadEntryView(tgi); }) {}
+
+    RecordCache::Result<Exemplar::Record> RecordCache::LoadExemplar(const Tgi& tgi) {
+        return Load(mExemplars, tgi, [](std::span<const uint8_t> data) { return Exemplar::Parse(data); });
+    }
+
+    RecordCache::Result<FSH::Record> RecordCache::LoadFSH(const Tgi& tgi) {
+        return Load(mFSH, tgi, [](std::span<const uint8_t> data) { return FSH::Reader::Parse(data); });
+    }
+
+    RecordCache::Result<S3D::Record> RecordCache::LoadS3D(const Tgi& tgi) {
+        return Load(mS3D, tgi, [](std::span<const uint8_t> data) { return S3D::Reader::Parse(data); });
+    }
+
+    RecordCache::Result<LText::Record> RecordCache::LoadLText(const Tgi& tgi) {
+        return Load(mLText, tgi, [](std::span<const uint8_t> data) { return LText::Parse(data); });
+    }
+
+    void RecordCache::Erase(const Tgi& tgi) {
+        std::lock_guard lock(mMutex);
+        EraseSlot(mExemplars, tgi);
+        EraseSlot(mFSH, tgi);
+        EraseSlot(mS3D, tgi);
+        EraseSlot(mLText, tgi);
+    }
+
+    void RecordCache::Clear() {
+        std::lock_guard lock(mMutex);
+        auto clear = [](auto& table) {
+            table.slots.clear();
+            table.stats.recordCount = 0;
+            table.stats.bytes = 0;
+        };
+        clear(mExemplars);
+        clear(mFSH);
+        clear(mS3D);
+        clear(mLText);
+    }
+
+    RecordCache::TypeStats RecordCache::GetStats(const RecordType type) const {
+        std::lock_guard lock(mMutex);
+        switch (type) {
+        case RecordType::kExemplar:
+            return mExemplars.stats;
+        case RecordType::kFSH:
+            return mFSH.stats;
+        case RecordType::kS3D:
+            return mS3D.stats;
+        case RecordType::kLText:
+            return mLText.stats;
+        }
+        return {};
+    }
+
+    size_t RecordCache::MemoryUsage() const {
+        std::lock_guard lock(mMutex);
+        return mExemplars.stats.bytes + mFSH.stats.bytes + mS3D.stats.bytes + mLText.stats.bytes;
+    }
+
+    template <typename Record, typename Parse>
+    RecordCache::Result<Record> RecordCache::Load(Table<Record>& table, const Tgi& tgi, Parse&& parse) {
+        std::promise<Result<Record>> promise;
+        uint64_t id = 0;
+        {
+            std::unique_lock lock(mMutex);
+            if (const auto it = table.slots.find(tgi); it != table.slots.end()) {
+                ++table.stats.hits;
+                if (!it->second.ready) {
+                    ++table.stats.coalesced;
+                }
+                auto pending = it->second.result;
+                lock.unlock();
+                return pending.get();
+            }
+            ++table.stats.misses;
+            id = ++mNextId;
+            table.slots.emplace(tgi, typename Table<Record>::Slot{promise.get_future().share(), id});
+        }
+
+        // Parse outside the lock; the slot's id tells whether it was erased or replaced in the meantime.
+        auto finish = [&](const Result<Record>& result, const size_t bytes) {
+            std::lock_guard lock(mMutex);
+            const auto it = table.slots.find(tgi);
+            const bool current = it != table.slots.end() && it->second.id == id;
+            if (!result.has_value()) {
+                ++table.stats.failures;
+                if (current) {
+                    table.slots.erase(it);
+                }
+                return;
+            }
+            if (current) {
+                it->second.ready = true;
+                it->second.bytes = bytes;
+                ++table.stats.recordCount;
+                table.stats.bytes += bytes;
+            }
+        };
+
+        Result<Record> result;
+        size_t bytes = 0;
+        try {
+            const auto payload = mSource(tgi);
+            if (!payload) {
+                result = Fail("Failed to read data for {}", tgi.ToString());
+            }
+            else if (auto parsed = parse(payload->Data()); parsed.has_value()) {
+                bytes = EstimateBytes(*parsed);
+                result = std::make_shared<const Record>(std::move(*parsed));
+            }
+            else {
+                result = std::unexpected(parsed.error());
+            }
+        }
+        catch (...) {
+            finish(Fail("Parsing {} threw", tgi.ToString()), 0);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        finish(result, bytes);
+        promise.set_value(result);
+        return result;
+    }
+
+    template <typename Record>
+    void RecordCache::EraseSlot(Table<Record>& table, const Tgi& tgi) {
+        const auto it = table.slots.find(tgi);
+        if (it == table.slots.end()) {
+            return;
+        }
+        if (it->second.ready) {
+            --table.stats.recordCount;
+            table.stats.bytes -= it->second.bytes;
+        }
+        table.slots.erase(it);
+    }
+
+} // namespace DBPF
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "DBPFReader.h"
+#include "ParseTypes.h"
+#include "TGI.h"
+
+namespace DBPF {
+
+    class PluginSet;
+
+    // Parsed Exemplar, FSH, S3D and LText records shared between callers. The first request for a TGI parses
+    // it; requests that arrive while that parse is running wait for it instead of parsing again, and later ones
+    // get the same immutable record. Failed parses are reported to everyone waiting but are not kept. All
+    // member functions may be called concurrently. The source must outlive the cache.
+    class RecordCache {
+    public:
+        using Source = std::function<std::optional<EntryView>(const Tgi& tgi)>;
+        template <typename Record>
+        using Result = ParseExpected<std::shared_ptr<const Record>>;
+
+        enum class RecordType {
+            kExemplar,
+            kFSH,
+            kS3D,
+            kLText
+        };
+
+        struct TypeStats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            // Requests that joined a parse already in progress; also counted as hits.
+            uint64_t coalesced = 0;
+            uint64_t failures = 0;
+            size_t recordCount = 0;
+            // Estimated heap footprint of the cached records.
+            size_t bytes = 0;
+        };
+
+        explicit RecordCache(Source source);
+        explicit RecordCache(const Reader& reader);
+        explicit RecordCache(const PluginSet& plugins);
+
+        [[nodiscard]] Result<Exemplar::Record> LoadExemplar(const Tgi& tgi);
+        [[nodiscard]] Result<FSH::Record> LoadFSH(const Tgi& tgi);
+        [[nodiscard]] Result<S3D::Record> LoadS3D(const Tgi& tgi);
+        [[nodiscard]] Result<LText::Record> LoadLText(const Tgi& tgi);
+
+        // Drops the records of every type for the TGI, e.g. after PluginSet::Refresh reports it changed.
+        void Erase(const Tgi& tgi);
+        void Clear();
+
+        [[nodiscard]] TypeStats GetStats(RecordType type) const;
+        [[nodiscard]] size_t MemoryUsage() const;
+
+    private:
+        template <typename Record>
+        struct Table {
+            struct Slot {
+                std::shared_future<Result<Record>> result;
+                uint64_t id = 0;
+                size_t bytes = 0;
+                bool ready = false;
+            };
+            std::unordered_map<Tgi, Slot, TgiHash> slots;
+            TypeStats stats;
+        };
+
+        template <typename Record, typename Parse>
+        Result<Record> Load(Table<Record>& table, const Tgi& tgi, Parse&& parse);
+        template <typename Record>
+        static void EraseSlot(Table<Record>& table, const Tgi& tgi);
+
+        Source mSource;
+        mutable std::mutex mMutex;
+        uint64_t mNextId = 0;
+        Table<Exemplar::Record> mExemplars;
+        Table<FSH::Record> mFSH;
+        Table<S3D::Record> mS3D;
+        Table<LText::Record> mLText;
+    };
+
+} // namespace DBPF
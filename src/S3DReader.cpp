@@ -6,6 +6,7 @@
 #include <type_traits>
 
 #include "SafeSpanReader.h"
+#include "Trace.h"
 
 // Helper macro to simplify reading and error checking for integral types
 #define READ_VALUE(reader, var) \
@@ -36,6 +37,7 @@ namespace S3D {
     constexpr auto kMagicAnim = "ANIM";
 
     ParseExpected<Record> Reader::Parse(std::span<const uint8_t> buffer) {
+        DBPFKIT_TRACE_SCOPE_BYTES("parse", "S3D::Parse", buffer.size());
         if (buffer.size() < 12) {
             return Fail("S3D buffer too small");
         }
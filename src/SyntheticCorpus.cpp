@@ -0,0 +1,516 @@
+#include "SyntheticCorpus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include "DBPFReader.h"
+#include "DBPFWriter.h"
+#include "TGI.h"
+#include "ThreadPool.h"
+
+namespace {
+
+    constexpr uint32_t kExemplarType = 0x6534284A;
+    constexpr uint32_t kFSHType = 0x7AB50E44;
+    constexpr uint32_t kS3DType = 0x5AD0E817;
+    constexpr uint32_t kLTextType = 0x2026960B;
+    // Fixed so the header dates do not make otherwise identical archives differ.
+    constexpr uint32_t kTimestamp = 1'100'000'000;
+    // Tree files are generated a few at a time, so each writer gets a smaller share of memory.
+    constexpr size_t kTreeInFlightBytes = 8 * 1024 * 1024;
+
+    constexpr std::string_view kWords[] = {
+        "Residential", "Commercial", "Industrial", "Landmark", "Park", "Highway", "Avenue", "Station",
+        "Tower", "Plaza", "Water", "Power", "Terrain", "Bridge", "Garden", "Market",
+    };
+
+    uint64_t Mix(const uint64_t seed, const uint64_t value) {
+        return Synthetic::Rng(seed ^ (value * 0xD1B54A32D192ED03ull)).Next();
+    }
+
+    template <typename T>
+    void Append(std::vector<uint8_t>& buffer, const T& value) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void AppendText(std::vector<uint8_t>& buffer, std::string_view text) {
+        buffer.insert(buffer.end(), text.begin(), text.end());
+    }
+
+    std::string_view Word(Synthetic::Rng& rng) {
+        return kWords[rng.Below(static_cast<uint32_t>(std::size(kWords)))];
+    }
+
+    enum class Kind {
+        kExemplar,
+        kFSH,
+        kS3D,
+        kLText
+    };
+
+    Kind PickKind(Synthetic::Rng& rng, const Synthetic::TypeMix& mix) {
+        const uint32_t total = mix.exemplar + mix.fsh + mix.s3d + mix.ltext;
+        if (total == 0) {
+            return Kind::kExemplar;
+        }
+        uint32_t pick = rng.Below(total);
+        if (pick < mix.exemplar) {
+            return Kind::kExemplar;
+        }
+        pick -= mix.exemplar;
+        if (pick < mix.fsh) {
+            return Kind::kFSH;
+        }
+        pick -= mix.fsh;
+        return pick < mix.s3d ? Kind::kS3D : Kind::kLText;
+    }
+
+    // Draws the kind, TGI and payload of the entry at index.
+    std::pair<DBPF::Tgi, std::vector<uint8_t>> MakeEntry(Synthetic::Rng& rng, const Synthetic::ArchiveSpec& spec,
+                                                         const uint32_t index) {
+        const uint32_t instance = spec.instanceSpace != 0 ? rng.Below(spec.instanceSpace) : 0x10000000u + index;
+        switch (PickKind(rng, spec.mix)) {
+        case Kind::kExemplar: {
+            const auto properties = 8 + rng.Below(40);
+            const uint32_t group = 0x6A000000u + rng.Below(16);
+            // Most shipped exemplars are binary; a few tools still emit the text form.
+            auto data = rng.Below(8) == 0 ? Synthetic::MakeTextExemplar(rng, properties)
+                                          : Synthetic::MakeExemplar(rng, properties);
+            return {DBPF::Tgi{kExemplarType, group, instance}, std::move(data)};
+        }
+        case Kind::kFSH: {
+            static constexpr uint16_t kSizes[] = {32, 64, 128, 256};
+            const uint16_t width = kSizes[rng.Below(4)];
+            const uint16_t height = kSizes[rng.Below(4)];
+            const uint32_t group = 0x1ABE787D;
+            return {DBPF::Tgi{kFSHType, group, instance},
+                    Synthetic::MakeFSH(rng, width, height, spec.compressibility)};
+        }
+        case Kind::kS3D: {
+            const auto blocks = static_cast<uint16_t>(1 + rng.Below(4));
+            const auto vertices = static_cast<uint16_t>(24 + rng.Below(600));
+            const uint32_t group = 0xBADB57F1;
+            return {DBPF::Tgi{kS3DType, group, instance}, Synthetic::MakeS3D(rng, blocks, vertices)};
+        }
+        case Kind::kLText:
+            break;
+        }
+        const uint32_t group = 0x6A231EA4;
+        return {DBPF::Tgi{kLTextType, group, instance}, Synthetic::MakeLText(rng, 8 + rng.Below(400))};
+    }
+
+    std::filesystem::path TreeFilePath(const std::filesystem::path& root, const Synthetic::TreeSpec& spec,
+                                       const size_t file, Synthetic::Rng& rng) {
+        static constexpr std::string_view kExtensions[] = {".dat", ".dat", ".dat", ".sc4lot", ".sc4desc", ".sc4model"};
+        // Directories are nested two deep like a typical Plugins folder sorted by creator and pack.
+        constexpr size_t kPacksPerCreator = 16;
+        const size_t perDirectory = std::max<size_t>(1, spec.filesPerDirectory);
+        const size_t pack = file / perDirectory;
+        const auto extension = kExtensions[rng.Below(static_cast<uint32_t>(std::size(kExtensions)))];
+        return root / std::format("creator_{:04}", pack / kPacksPerCreator) / std::format("pack_{:06}", pack) /
+               std::format("{}_{:07}{}", Word(rng), file, extension);
+    }
+
+} // namespace
+
+namespace Synthetic {
+
+    std::vector<uint8_t> MakeFiller(Rng& rng, const size_t size, const double compressibility) {
+        // Chunks are either fresh noise or a repeat of one of a few recent chunks, so the share of repeats sets
+        // how well the result compresses.
+        constexpr size_t kChunk = 16;
+        constexpr size_t kHistory = 8;
+        const auto repeatThreshold = static_cast<uint64_t>(std::clamp(compressibility, 0.0, 1.0) * 0x1.0p32);
+        std::vector<uint8_t> data(size);
+        size_t pos = 0;
+        size_t chunkIndex = 0;
+        while (pos < size) {
+            const size_t length = std::min(kChunk, size - pos);
+            const uint64_t roll = rng.Next();
+            if (chunkIndex >= kHistory && (roll >> 32) < repeatThreshold) {
+                const size_t back = (1 + (roll & (kHistory - 1))) * kChunk;
+                std::memcpy(data.data() + pos, data.data() + pos - back, length);
+            }
+            else {
+                for (size_t i = 0; i < length; i += 8) {
+                    const uint64_t bits = rng.Next();
+                    std::memcpy(data.data() + pos + i, &bits, std::min<size_t>(8, length - i));
+                }
+            }
+            pos += length;
+            ++chunkIndex;
+        }
+        return data;
+    }
+
+    std::vector<uint8_t> MakeExemplar(Rng& rng, const size_t propertyCount) {
+        std::vector<uint8_t> buffer;
+        AppendText(buffer, "EQZB1###");
+        Append(buffer, uint32_t{0});
+        Append(buffer, uint32_t{0});
+        Append(buffer, uint32_t{0});
+        Append(buffer, static_cast<uint32_t>(propertyCount + 1));
+
+        // Exemplar Type comes first, as in game files.
+        Append(buffer, uint32_t{0x00000010});
+        Append(buffer, uint16_t{0x0300});
+        Append(buffer, uint16_t{0x0000});
+        buffer.push_back(0);
+        Append(buffer, static_cast<uint32_t>(1 + rng.Below(0x20)));
+
+        for (uint32_t i = 0; i < propertyCount; ++i) {
+            const uint32_t id = 0x20000000u + (i << 8) + rng.Below(0x100);
+            Append(buffer, id);
+            switch (rng.Below(4)) {
+            case 0:
+                Append(buffer, uint16_t{0x0300});
+                Append(buffer, uint16_t{0x0000});
+                buffer.push_back(0);
+                Append(buffer, static_cast<uint32_t>(rng.Next()));
+                break;
+            case 1: {
+                const uint32_t count = 1 + rng.Below(8);
+                Append(buffer, uint16_t{0x0900});
+                Append(buffer, uint16_t{0x0080});
+                buffer.push_back(0);
+                Append(buffer, count);
+                for (uint32_t v = 0; v < count; ++v) {
+                    Append(buffer, static_cast<float>(rng.Below(100000)) * 0.01f);
+                }
+                break;
+            }
+            case 2: {
+                const uint32_t count = 1 + rng.Below(6);
+                Append(buffer, uint16_t{0x0300});
+                Append(buffer, uint16_t{0x0080});
+                buffer.push_back(0);
+                Append(buffer, count);
+                for (uint32_t v = 0; v < count; ++v) {
+                    Append(buffer, static_cast<uint32_t>(rng.Next()));
+                }
+                break;
+            }
+            default: {
+                const std::string value = std::format("{} {} {}", Word(rng), Word(rng), rng.Below(1000));
+                Append(buffer, uint16_t{0x0C00});
+                Append(buffer, uint16_t{0x0000});
+                buffer.push_back(static_cast<uint8_t>(value.size()));
+                AppendText(buffer, value);
+                break;
+            }
+            }
+        }
+        return buffer;
+    }
+
+    std::vector<uint8_t> MakeTextExemplar(Rng& rng, const size_t propertyCount) {
+        std::string text = "EQZT1###\nParentCohort=Key:{0x00000000,0x00000000,0x00000000}\n";
+        text += std::format("PropCount=0x{:08X}\n", propertyCount + 1);
+        text += std::format("0x00000010:{{\"Exemplar Type\"}}=Uint32:0:{{0x{:08X}}}\n", 1 + rng.Below(0x20));
+        for (uint32_t i = 0; i < propertyCount; ++i) {
+            const uint32_t id = 0x20000000u + (i << 8) + rng.Below(0x100);
+            switch (rng.Below(3)) {
+            case 0:
+                text += std::format("0x{:08X}:{{\"{} {}\"}}=Uint32:0:{{0x{:08X}}}\n",
+                                    id, Word(rng), i, static_cast<uint32_t>(rng.Next()));
+                break;
+            case 1:
+                text += std::format("0x{:08X}:{{\"{} {}\"}}=Float32:3:{{{:.2f},{:.2f},{:.2f}}}\n", id, Word(rng),
+                                    i, rng.Below(10000) * 0.01, rng.Below(10000) * 0.01, rng.Below(10000) * 0.01);
+                break;
+            default:
+                text += std::format("0x{:08X}:{{\"{} {}\"}}=String:0:{{\"{} {}\"}}\n",
+                                    id, Word(rng), i, Word(rng), Word(rng));
+                break;
+            }
+        }
+        return {text.begin(), text.end()};
+    }
+
+    std::vector<uint8_t> MakeFSH(Rng& rng, const uint16_t width, const uint16_t height, const double compressibility) {
+        constexpr size_t kHeaderSize = 16;
+        constexpr size_t kDirectorySize = 8;
+        constexpr size_t kEntryHeaderSize = 16;
+        const size_t dataSize = static_cast<size_t>(width / 4) * (height / 4) * 8;
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(kHeaderSize + kDirectorySize + kEntryHeaderSize + dataSize);
+        AppendText(buffer, "SHPI");
+        Append(buffer, static_cast<uint32_t>(kHeaderSize + kDirectorySize + kEntryHeaderSize + dataSize));
+        Append(buffer, uint32_t{1});
+        AppendText(buffer, "G264");
+        AppendText(buffer, std::format("{:04x}", rng.Below(0x10000)));
+        Append(buffer, static_cast<uint32_t>(kHeaderSize + kDirectorySize));
+
+        // Code 0x60 (DXT1) with a zero block size marks the last entry.
+        Append(buffer, uint32_t{0x60});
+        Append(buffer, width);
+        Append(buffer, height);
+        for (int field = 0; field < 4; ++field) {
+            Append(buffer, uint16_t{0});
+        }
+        // Any bytes form valid DXT1 blocks.
+        const auto pixels = MakeFiller(rng, dataSize, compressibility);
+        buffer.insert(buffer.end(), pixels.begin(), pixels.end());
+        return buffer;
+    }
+
+    std::vector<uint8_t> MakeS3D(Rng& rng, const uint16_t blockCount, const uint16_t verticesPerBlock) {
+        std::vector<uint8_t> buffer;
+        auto beginChunk = [&](std::string_view magic) {
+            AppendText(buffer, magic);
+            const size_t lengthAt = buffer.size();
+            Append(buffer, uint32_t{0});
+            return lengthAt;
+        };
+        auto endChunk = [&](const size_t lengthAt) {
+            const auto length = static_cast<uint32_t>(buffer.size() - lengthAt - 4);
+            std::memcpy(buffer.data() + lengthAt, &length, sizeof(length));
+        };
+
+        // A 1.5 model with textured, coloured vertices split over blocks, plus materials and one animated mesh.
+        const size_t total = beginChunk("3DMD");
+        const size_t head = beginChunk("HEAD");
+        Append(buffer, uint16_t{1});
+        Append(buffer, uint16_t{5});
+        endChunk(head);
+
+        const size_t vert = beginChunk("VERT");
+        Append(buffer, static_cast<uint32_t>(blockCount));
+        constexpr uint32_t kFormat = 0x80000000u | 1u | (1u << 8) | (1u << 14);
+        for (uint16_t block = 0; block < blockCount; ++block) {
+            Append(buffer, uint16_t{0});
+            Append(buffer, verticesPerBlock);
+            Append(buffer, kFormat);
+            for (uint16_t v = 0; v < verticesPerBlock; ++v) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    Append(buffer, static_cast<float>(rng.Below(1000)) * 0.01f);
+                }
+                Append(buffer, static_cast<uint32_t>(rng.Next()));
+                Append(buffer, static_cast<float>(v % 16) / 16.0f);
+                Append(buffer, static_cast<float>(v / 16 % 16) / 16.0f);
+            }
+        }
+        endChunk(vert);
+
+        const auto indexCount = static_cast<uint16_t>(verticesPerBlock / 3 * 3);
+        const size_t indx = beginChunk("INDX");
+        Append(buffer, static_cast<uint32_t>(blockCount));
+        for (uint16_t block = 0; block < blockCount; ++block) {
+            Append(buffer, uint16_t{0});
+            Append(buffer, uint16_t{2});
+            Append(buffer, indexCount);
+            for (uint16_t i = 0; i < indexCount; ++i) {
+                Append(buffer, i);
+            }
+        }
+        endChunk(indx);
+
+        const size_t prim = beginChunk("PRIM");
+        Append(buffer, static_cast<uint32_t>(blockCount));
+        for (uint16_t block = 0; block < blockCount; ++block) {
+            Append(buffer, uint16_t{1});
+            Append(buffer, uint32_t{0});
+            Append(buffer, uint32_t{0});
+            Append(buffer, static_cast<uint32_t>(indexCount));
+        }
+        endChunk(prim);
+
+        const size_t mats = beginChunk("MATS");
+        Append(buffer, static_cast<uint32_t>(blockCount));
+        for (uint16_t block = 0; block < blockCount; ++block) {
+            Append(buffer, uint32_t{0x2B});
+            buffer.insert(buffer.end(), {7, 3, 5, 6});
+            Append(buffer, uint16_t{0x7FFF});
+            Append(buffer, uint32_t{0});
+            buffer.push_back(0);
+            buffer.push_back(1);
+            Append(buffer, 0x10000000u + rng.Below(0x10000));
+            buffer.insert(buffer.end(), {0, 0, 1, 1});
+            Append(buffer, uint16_t{0});
+            Append(buffer, uint16_t{0});
+            buffer.push_back(0);
+        }
+        endChunk(mats);
+
+        const size_t anim = beginChunk("ANIM");
+        Append(buffer, uint16_t{1});
+        Append(buffer, uint16_t{0});
+        Append(buffer, uint16_t{0});
+        Append(buffer, uint32_t{0});
+        Append(buffer, 0.0f);
+        Append(buffer, blockCount);
+        for (uint16_t block = 0; block < blockCount; ++block) {
+            const std::string name = std::format("mesh{}", block);
+            buffer.push_back(static_cast<uint8_t>(name.size()));
+            buffer.push_back(0);
+            AppendText(buffer, name);
+            for (int field = 0; field < 4; ++field) {
+                Append(buffer, block);
+            }
+        }
+        endChunk(anim);
+        endChunk(total);
+        return buffer;
+    }
+
+    std::vector<uint8_t> MakeLText(Rng& rng, const size_t characterCount) {
+        const size_t count = std::min<size_t>(characterCount, 0xFFFF);
+        std::u16string text;
+        text.reserve(count);
+        while (text.size() < count) {
+            // Mostly ASCII words with the odd accented character.
+            for (const char c : Word(rng)) {
+                text.push_back(rng.Below(32) == 0 ? u'\u00E9' : static_cast<char16_t>(c));
+            }
+            text.push_back(u' ');
+        }
+        text.resize(count);
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(4 + count * 2);
+        Append(buffer, static_cast<uint16_t>(count));
+        Append(buffer, uint16_t{0x1000});
+        for (const char16_t unit : text) {
+            Append(buffer, static_cast<uint16_t>(unit));
+        }
+        return buffer;
+    }
+
+    std::vector<uint8_t> MakeRUL0(Rng& rng, const size_t ringCount) {
+        // Every ring holds a base piece and its three rotated, transposed and translated copies.
+        std::string text;
+        for (size_t ring = 0; ring < ringCount; ++ring) {
+            const auto base = static_cast<uint32_t>(0x00010000u + ring * 4);
+            text += std::format("RotationRing=0x{:08X},0x{:08X},0x{:08X},0x{:08X}\n", base, base + 1, base + 2,
+                                base + 3);
+            text += std::format("AddTypes=0x{:08X}\n", base + 1);
+        }
+        for (size_t ring = 0; ring < ringCount; ++ring) {
+            const auto base = static_cast<uint32_t>(0x00010000u + ring * 4);
+            text += std::format("\n[HighwayIntersectionInfo_0x{:08X}]\n", base);
+            text += std::format("Piece={:.1f}, {:.1f}, 0, 0, 0x{:08X}\n", rng.Below(8) * 8.0, rng.Below(8) * 8.0,
+                                0x5D000000u + rng.Below(0x10000));
+            text += "CellLayout=a.\nCellLayout=^<\nConsLayout=x.\nConsLayout=.|\n";
+            text += std::format("CheckType=a - road: 0x{:08X}\n", 0x02000200u);
+            text += std::format("AutoTileBase=0x{:08X}\n", 0x55000000u + rng.Below(0x10000));
+            text += std::format("Costs={}\n", 100 + rng.Below(900));
+            text += std::format("\n[HighwayIntersectionInfo_0x{:08X}]\nCopyFrom=0x{:08X}\nRotate=1\n", base + 1, base);
+            text += std::format("\n[HighwayIntersectionInfo_0x{:08X}]\nCopyFrom=0x{:08X}\nTranspose=1\n", base + 2,
+                                base);
+            text += std::format("\n[HighwayIntersectionInfo_0x{:08X}]\nCopyFrom=0x{:08X}\nTranslate=1,1\n", base + 3,
+                                base);
+        }
+        return {text.begin(), text.end()};
+    }
+
+    std::optional<Summary> WriteArchive(const std::filesystem::path& path, const ArchiveSpec& spec,
+                                        DBPF::ThreadPool* pool) {
+        DBPF::Writer writer(pool);
+        return WriteArchive(writer, path, spec);
+    }
+
+    std::optional<Summary> WriteArchive(DBPF::Writer& writer, const std::filesystem::path& path,
+                                        const ArchiveSpec& spec) {
+        if (!writer.Open(path)) {
+            return std::nullopt;
+        }
+        writer.SetCompressionLevel(spec.level);
+        writer.SetDirectoryEnabled(spec.writeDirectory);
+        writer.SetTimestamp(kTimestamp);
+
+        Rng rng(spec.seed);
+        Summary summary;
+        summary.files = 1;
+        for (size_t i = 0; i < spec.entryCount; ++i) {
+            auto [tgi, data] = MakeEntry(rng, spec, static_cast<uint32_t>(i));
+            const bool compress = rng.Unit() < spec.compressedFraction;
+            if (!writer.Add(tgi, std::move(data), compress)) {
+                return std::nullopt;
+            }
+            ++summary.entries;
+        }
+        if (spec.includeRul0) {
+            if (!writer.Add(DBPF::kRul0Tgi, MakeRUL0(rng, 1 + rng.Below(16)), rng.Unit() < spec.compressedFraction)) {
+                return std::nullopt;
+            }
+            ++summary.entries;
+        }
+        if (!writer.Finish()) {
+            return std::nullopt;
+        }
+
+        std::error_code ec;
+        summary.bytes = std::filesystem::file_size(path, ec);
+        return summary;
+    }
+
+    std::optional<Summary> WriteTree(const std::filesystem::path& root, const TreeSpec& spec,
+                                     DBPF::ThreadPool* pool) {
+        DBPF::ThreadPool& compressionPool = pool ? *pool : DBPF::ThreadPool::Shared();
+        const size_t workerCount = std::clamp<size_t>(
+            spec.threadCount != 0 ? spec.threadCount : std::thread::hardware_concurrency(), 1,
+            std::max<size_t>(1, spec.fileCount));
+        const size_t minEntries = std::min(spec.minEntries, spec.maxEntries);
+        const auto entrySpread = static_cast<uint32_t>(spec.maxEntries - minEntries + 1);
+
+        // Files are claimed from a shared counter on plain threads; their compression goes to the pool, so a
+        // writer never waits on a task queued behind itself.
+        std::atomic<size_t> nextFile{0};
+        std::atomic<bool> failed{false};
+        std::mutex summaryMutex;
+        Summary summary;
+        auto work = [&] {
+            DBPF::Writer writer(&compressionPool, kTreeInFlightBytes);
+            while (!failed.load(std::memory_order_relaxed)) {
+                const size_t file = nextFile.fetch_add(1, std::memory_order_relaxed);
+                if (file >= spec.fileCount) {
+                    return;
+                }
+
+                Rng rng(Mix(spec.seed, file));
+                ArchiveSpec archive = spec.archive;
+                archive.seed = rng.Next();
+                archive.entryCount = minEntries + rng.Below(entrySpread);
+                const auto path = TreeFilePath(root, spec, file, rng);
+
+                std::error_code ec;
+                std::filesystem::create_directories(path.parent_path(), ec);
+                const auto written = ec ? std::nullopt : WriteArchive(writer, path, archive);
+                if (!written) {
+                    std::println("[Synthetic] Failed to write {}", path.string());
+                    failed = true;
+                    return;
+                }
+                std::lock_guard lock(summaryMutex);
+                summary.files += written->files;
+                summary.entries += written->entries;
+                summary.bytes += written->bytes;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount - 1);
+        for (size_t i = 1; i < workerCount; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        if (failed) {
+            return std::nullopt;
+        }
+        return summary;
+    }
+
+} // namespace Synthetic
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "QFSCompressor.h"
+
+namespace DBPF {
+    class ThreadPool;
+    class Writer;
+}
+
+// Deterministic generator of synthetic but valid archives and Plugins trees for benchmarks and stress tests.
+// The same seed and spec always produce byte-identical files, regardless of thread count or platform.
+namespace Synthetic {
+
+    // SplitMix64. Kept here instead of using <random> so sequences match across standard libraries.
+    class Rng {
+    public:
+        explicit Rng(const uint64_t seed)
+            : mState(seed) {}
+
+        uint64_t Next() {
+            uint64_t z = (mState += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+        // Uniform in [0, bound); bound must be non-zero.
+        uint32_t Below(const uint32_t bound) { return static_cast<uint32_t>((Next() >> 32) * bound >> 32); }
+        // Uniform in [0, 1).
+        double Unit() { return static_cast<double>(Next() >> 11) * 0x1.0p-53; }
+
+    private:
+        uint64_t mState;
+    };
+
+    // Relative weights of the entry kinds in an archive.
+    struct TypeMix {
+        uint32_t exemplar = 60;
+        uint32_t fsh = 15;
+        uint32_t s3d = 10;
+        uint32_t ltext = 15;
+    };
+
+    struct ArchiveSpec {
+        uint64_t seed = 1;
+        size_t entryCount = 1000;
+        TypeMix mix{};
+        // Adds one RUL0 entry on top of entryCount.
+        bool includeRul0 = false;
+        // How repetitive texture bytes are, from 0 (incompressible noise) to 1 (only repeats of recent bytes).
+        double compressibility = 0.6;
+        // Share of entries stored QFS-compressed (and listed in the directory).
+        double compressedFraction = 0.5;
+        bool writeDirectory = true;
+        QFS::Compressor::Level level = QFS::Compressor::Level::kFast;
+        // When non-zero, instances are drawn from [0, instanceSpace) so archives built from different seeds share
+        // TGIs and override each other. Otherwise instances are unique within the archive.
+        uint32_t instanceSpace = 0;
+    };
+
+    struct TreeSpec {
+        uint64_t seed = 1;
+        size_t fileCount = 1000;
+        size_t filesPerDirectory = 50;
+        size_t minEntries = 10;
+        size_t maxEntries = 200;
+        // Settings for every file; the seed and entry count are chosen per file.
+        ArchiveSpec archive{};
+        // Files generated at once; 0 uses the hardware concurrency.
+        size_t threadCount = 0;
+    };
+
+    struct Summary {
+        size_t files = 0;
+        size_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Payload builders, also usable on their own.
+    [[nodiscard]] std::vector<uint8_t> MakeFiller(Rng& rng, size_t size, double compressibility);
+    [[nodiscard]] std::vector<uint8_t> MakeExemplar(Rng& rng, size_t propertyCount);
+    [[nodiscard]] std::vector<uint8_t> MakeTextExemplar(Rng& rng, size_t propertyCount);
+    // A single-bitmap DXT1 FSH; width and height must be multiples of 4.
+    [[nodiscard]] std::vector<uint8_t> MakeFSH(Rng& rng, uint16_t width, uint16_t height, double compressibility);
+    [[nodiscard]] std::vector<uint8_t> MakeS3D(Rng& rng, uint16_t blockCount, uint16_t verticesPerBlock);
+    [[nodiscard]] std::vector<uint8_t> MakeLText(Rng& rng, size_t characterCount);
+    [[nodiscard]] std::vector<uint8_t> MakeRUL0(Rng& rng, size_t ringCount);
+
+    // Compression runs on the pool (ThreadPool::Shared() when null).
+    std::optional<Summary> WriteArchive(const std::filesystem::path& path, const ArchiveSpec& spec,
+                                        DBPF::ThreadPool* pool = nullptr);
+    // Same, reusing an existing writer; its compression level and directory setting are taken from the spec.
+    std::optional<Summary> WriteArchive(DBPF::Writer& writer, const std::filesystem::path& path,
+                                        const ArchiveSpec& spec);
+    // Writes fileCount archives with plugin extensions into nested directories below root.
+    std::optional<Summary> WriteTree(const std::filesystem::path& root, const TreeSpec& spec,
+                                     DBPF::ThreadPool* pool = nullptr);
+
+} // namespace Synthetic
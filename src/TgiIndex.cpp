@@ -0,0 +1,347 @@
+#include "TgiIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <tuple>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DBPFKIT_TGI_SCAN_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#define DBPFKIT_TARGET_AVX2
+#else
+#include <immintrin.h>
+#define DBPFKIT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+    // A disabled component gets a zero care mask, so every row compares equal on it.
+    struct ScanKey {
+        uint32_t type = 0;
+        uint32_t group = 0;
+        uint32_t instance = 0;
+        uint32_t typeCare = 0;
+        uint32_t groupCare = 0;
+        uint32_t instanceCare = 0;
+    };
+
+    struct ScanColumns {
+        const uint32_t* types;
+        const uint32_t* groups;
+        const uint32_t* instances;
+        const uint32_t* positions;
+    };
+
+    using ScanFn = void (*)(const ScanColumns& columns, uint32_t begin, uint32_t end, const ScanKey& key,
+                            std::vector<uint32_t>& out);
+
+    void ScanScalar(const ScanColumns& columns, const uint32_t begin, const uint32_t end, const ScanKey& key,
+                    std::vector<uint32_t>& out) {
+        for (uint32_t row = begin; row < end; ++row) {
+            const uint32_t diff = ((columns.types[row] ^ key.type) & key.typeCare) |
+                                  ((columns.groups[row] ^ key.group) & key.groupCare) |
+                                  ((columns.instances[row] ^ key.instance) & key.instanceCare);
+            if (diff == 0) {
+                out.push_back(columns.positions[row]);
+            }
+        }
+    }
+
+#ifdef DBPFKIT_TGI_SCAN_X86
+    void AppendLanes(const ScanColumns& columns, const uint32_t row, uint32_t lanes, std::vector<uint32_t>& out) {
+        while (lanes != 0) {
+            out.push_back(columns.positions[row + std::countr_zero(lanes)]);
+            lanes &= lanes - 1;
+        }
+    }
+
+    void ScanSse2(const ScanColumns& columns, const uint32_t begin, const uint32_t end, const ScanKey& key,
+                  std::vector<uint32_t>& out) {
+        const __m128i type = _mm_set1_epi32(static_cast<int>(key.type));
+        const __m128i group = _mm_set1_epi32(static_cast<int>(key.group));
+        const __m128i instance = _mm_set1_epi32(static_cast<int>(key.instance));
+        const __m128i typeCare = _mm_set1_epi32(static_cast<int>(key.typeCare));
+        const __m128i groupCare = _mm_set1_epi32(static_cast<int>(key.groupCare));
+        const __m128i instanceCare = _mm_set1_epi32(static_cast<int>(key.instanceCare));
+        const __m128i zero = _mm_setzero_si128();
+
+        uint32_t row = begin;
+        for (; end - row >= 4; row += 4) {
+            const auto* t = reinterpret_cast<const __m128i*>(columns.types + row);
+            const auto* g = reinterpret_cast<const __m128i*>(columns.groups + row);
+            const auto* i = reinterpret_cast<const __m128i*>(columns.instances + row);
+            const __m128i diff =
+                _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_xor_si128(_mm_loadu_si128(t), type), typeCare),
+                                          _mm_and_si128(_mm_xor_si128(_mm_loadu_si128(g), group), groupCare)),
+                             _mm_and_si128(_mm_xor_si128(_mm_loadu_si128(i), instance), instanceCare));
+            const int lanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(diff, zero)));
+            AppendLanes(columns, row, static_cast<uint32_t>(lanes), out);
+        }
+        ScanScalar(columns, row, end, key, out);
+    }
+
+    DBPFKIT_TARGET_AVX2 void ScanAvx2(const ScanColumns& columns, const uint32_t begin, const uint32_t end,
+                                      const ScanKey& key, std::vector<uint32_t>& out) {
+        const __m256i type = _mm256_set1_epi32(static_cast<int>(key.type));
+        const __m256i group = _mm256_set1_epi32(static_cast<int>(key.group));
+        const __m256i instance = _mm256_set1_epi32(static_cast<int>(key.instance));
+        const __m256i typeCare = _mm256_set1_epi32(static_cast<int>(key.typeCare));
+        const __m256i groupCare = _mm256_set1_epi32(static_cast<int>(key.groupCare));
+        const __m256i instanceCare = _mm256_set1_epi32(static_cast<int>(key.instanceCare));
+        const __m256i zero = _mm256_setzero_si256();
+
+        uint32_t row = begin;
+        for (; end - row >= 8; row += 8) {
+            const auto* t = reinterpret_cast<const __m256i*>(columns.types + row);
+            const auto* g = reinterpret_cast<const __m256i*>(columns.groups + row);
+            const auto* i = reinterpret_cast<const __m256i*>(columns.instances + row);
+            const __m256i diff = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256(t), type), typeCare),
+                                _mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256(g), group), groupCare)),
+                _mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256(i), instance), instanceCare));
+            const int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(diff, zero)));
+            AppendLanes(columns, row, static_cast<uint32_t>(lanes), out);
+        }
+        ScanSse2(columns, row, end, key, out);
+    }
+
+    bool CpuSupportsAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        constexpr int kOsXsave = 1 << 27;
+        constexpr int kAvx = 1 << 28;
+        if ((info[2] & kOsXsave) == 0 || (info[2] & kAvx) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    ScanFn SelectScan() {
+#ifdef DBPFKIT_TGI_SCAN_X86
+        return CpuSupportsAvx2() ? ScanAvx2 : ScanSse2;
+#else
+        return ScanScalar;
+#endif
+    }
+
+    // Rows a vectorized scan compares per step; used to weigh a full scan against a permutation intersection.
+    constexpr size_t kScanRowsPerStep = 8;
+
+    // Puts distinct positions below indexSize back in ascending order. Large results are rebuilt with one pass
+    // over a bitmap of the index instead of a sort, so the cost stays linear in the archive size.
+    void SortPositions(std::span<uint32_t> positions, const size_t indexSize) {
+        const size_t count = positions.size();
+        if (count * std::bit_width(count) <= indexSize) {
+            std::ranges::sort(positions);
+            return;
+        }
+        std::vector<bool> matched(indexSize);
+        for (const auto position : positions) {
+            matched[position] = true;
+        }
+        auto out = positions.begin();
+        for (uint32_t position = 0; position < indexSize; ++position) {
+            if (matched[position]) {
+                *out++ = position;
+            }
+        }
+    }
+
+} // namespace
+
+namespace DBPF {
+
+    void TgiIndex::Build(std::span<const IndexEntry> entries) {
+        const auto count = static_cast<uint32_t>(entries.size());
+
+        std::vector<uint32_t> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::sort(order, [&](const uint32_t lhs, const uint32_t rhs) {
+            return std::tie(entries[lhs].tgi, lhs) < std::tie(entries[rhs].tgi, rhs);
+        });
+
+        mTypes.resize(count);
+        mGroups.resize(count);
+        mInstances.resize(count);
+        for (uint32_t row = 0; row < count; ++row) {
+            const auto& tgi = entries[order[row]].tgi;
+            mTypes[row] = tgi.type;
+            mGroups[row] = tgi.group;
+            mInstances[row] = tgi.instance;
+        }
+        mPositions = std::move(order);
+
+        mRowsByGroup.resize(count);
+        std::iota(mRowsByGroup.begin(), mRowsByGroup.end(), 0u);
+        std::ranges::stable_sort(mRowsByGroup, {}, [this](const uint32_t row) { return mGroups[row]; });
+
+        mRowsByInstance.resize(count);
+        std::iota(mRowsByInstance.begin(), mRowsByInstance.end(), 0u);
+        std::ranges::stable_sort(mRowsByInstance, {}, [this](const uint32_t row) { return mInstances[row]; });
+    }
+
+    void TgiIndex::Clear() {
+        mTypes.clear();
+        mGroups.clear();
+        mInstances.clear();
+        mPositions.clear();
+        mRowsByGroup.clear();
+        mRowsByInstance.clear();
+    }
+
+    std::optional<uint32_t> TgiIndex::Find(const Tgi& tgi) const {
+        RowRange rows = EqualRange(mTypes, RowRange{0, static_cast<uint32_t>(Size())}, tgi.type);
+        rows = EqualRange(mGroups, rows, tgi.group);
+        rows = EqualRange(mInstances, rows, tgi.instance);
+        if (rows.begin == rows.end) {
+            return std::nullopt;
+        }
+        return mPositions[rows.begin];
+    }
+
+    void TgiIndex::FindMatching(const TgiMask& mask, std::vector<uint32_t>& out) const {
+        const size_t first = out.size();
+        if (!mask.type.has_value() && !mask.group.has_value() && !mask.instance.has_value()) {
+            out.resize(first + Size());
+            std::iota(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), 0u);
+            return;
+        }
+        AppendMatching(mask, out);
+        // Every lookup path yields rows in TGI order, but callers expect index order.
+        SortPositions(std::span<uint32_t>(out).subspan(first), Size());
+    }
+
+    void TgiIndex::AppendMatching(const TgiMask& mask, std::vector<uint32_t>& out) const {
+        const RowRange all{0, static_cast<uint32_t>(Size())};
+
+        if (mask.type.has_value()) {
+            // Rows are sorted by type, then group, then instance, so each leading component narrows a contiguous run.
+            RowRange rows = EqualRange(mTypes, all, *mask.type);
+            if (mask.group.has_value()) {
+                rows = EqualRange(mGroups, rows, *mask.group);
+                if (mask.instance.has_value()) {
+                    rows = EqualRange(mInstances, rows, *mask.instance);
+                }
+            } else if (mask.instance.has_value()) {
+                AppendScanned(rows, mask, out);
+                return;
+            }
+            AppendRows(rows, out);
+            return;
+        }
+
+        if (mask.group.has_value() && mask.instance.has_value()) {
+            const RowRange groupRange = EqualRangeVia(mRowsByGroup, mGroups, *mask.group);
+            const RowRange instanceRange = EqualRangeVia(mRowsByInstance, mInstances, *mask.instance);
+            const size_t groupCount = groupRange.end - groupRange.begin;
+            const size_t instanceCount = instanceRange.end - instanceRange.begin;
+            const size_t intersectCost = std::min(groupCount, instanceCount) *
+                                         std::bit_width(std::max(groupCount, instanceCount));
+            if (intersectCost * kScanRowsPerStep <= Size()) {
+                AppendIntersection(groupRange, instanceRange, out);
+            } else {
+                AppendScanned(all, mask, out);
+            }
+            return;
+        }
+
+        if (mask.group.has_value()) {
+            AppendRowsVia(mRowsByGroup, EqualRangeVia(mRowsByGroup, mGroups, *mask.group), out);
+            return;
+        }
+
+        if (mask.instance.has_value()) {
+            AppendRowsVia(mRowsByInstance, EqualRangeVia(mRowsByInstance, mInstances, *mask.instance), out);
+            return;
+        }
+
+        AppendRows(all, out);
+    }
+
+    size_t TgiIndex::MemoryUsage() const {
+        return sizeof(uint32_t) * (mTypes.capacity() + mGroups.capacity() + mInstances.capacity() +
+                                   mPositions.capacity() + mRowsByGroup.capacity() + mRowsByInstance.capacity());
+    }
+
+    TgiIndex::RowRange TgiIndex::EqualRange(const std::vector<uint32_t>& column, const RowRange rows,
+                                            const uint32_t value) {
+        const auto first = column.begin() + rows.begin;
+        const auto last = column.begin() + rows.end;
+        const auto [lo, hi] = std::equal_range(first, last, value);
+        return RowRange{static_cast<uint32_t>(lo - column.begin()), static_cast<uint32_t>(hi - column.begin())};
+    }
+
+    TgiIndex::RowRange TgiIndex::EqualRangeVia(const std::vector<uint32_t>& permutation,
+                                               const std::vector<uint32_t>& column, const uint32_t value) {
+        const auto [lo, hi] = std::ranges::equal_range(permutation, value, {},
+                                                       [&column](const uint32_t row) { return column[row]; });
+        return RowRange{static_cast<uint32_t>(lo - permutation.begin()), static_cast<uint32_t>(hi - permutation.begin())};
+    }
+
+    void TgiIndex::AppendRows(const RowRange rows, std::vector<uint32_t>& out) const {
+        out.insert(out.end(), mPositions.begin() + rows.begin, mPositions.begin() + rows.end);
+    }
+
+    void TgiIndex::AppendRowsVia(const std::vector<uint32_t>& permutation, const RowRange range,
+                                 std::vector<uint32_t>& out) const {
+        for (uint32_t i = range.begin; i < range.end; ++i) {
+            out.push_back(mPositions[permutation[i]]);
+        }
+    }
+
+    void TgiIndex::AppendIntersection(const RowRange groupRange, const RowRange instanceRange,
+                                      std::vector<uint32_t>& out) const {
+        // Both permutations are stable, so the rows sharing one key are in ascending order. Walk the shorter run
+        // and binary search forward through the longer one.
+        auto shortFirst = mRowsByGroup.begin() + groupRange.begin;
+        auto shortLast = mRowsByGroup.begin() + groupRange.end;
+        auto longFirst = mRowsByInstance.begin() + instanceRange.begin;
+        auto longLast = mRowsByInstance.begin() + instanceRange.end;
+        if (shortLast - shortFirst > longLast - longFirst) {
+            std::swap(shortFirst, longFirst);
+            std::swap(shortLast, longLast);
+        }
+
+        for (; shortFirst != shortLast && longFirst != longLast; ++shortFirst) {
+            longFirst = std::lower_bound(longFirst, longLast, *shortFirst);
+            if (longFirst != longLast && *longFirst == *shortFirst) {
+                out.push_back(mPositions[*shortFirst]);
+            }
+        }
+    }
+
+    void TgiIndex::AppendScanned(const RowRange rows, const TgiMask& mask, std::vector<uint32_t>& out) const {
+        static const ScanFn scan = SelectScan();
+
+        ScanKey key;
+        if (mask.type.has_value()) {
+            key.type = *mask.type;
+            key.typeCare = ~0u;
+        }
+        if (mask.group.has_value()) {
+            key.group = *mask.group;
+            key.groupCare = ~0u;
+        }
+        if (mask.instance.has_value()) {
+            key.instance = *mask.instance;
+            key.instanceCare = ~0u;
+        }
+
+        const ScanColumns columns{mTypes.data(), mGroups.data(), mInstances.data(), mPositions.data()};
+        scan(columns, rows.begin, rows.end, key, out);
+    }
+
+} // namespace DBPF
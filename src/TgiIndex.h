@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "DBPFStructures.h"
+
+namespace DBPF {
+
+    // Flat structure-of-arrays lookup over an archive's index. Rows are sorted by (type, group, instance) and
+    // store the position of the entry in the source index; two permutations keep the rows ordered by group and
+    // by instance for masks that leave the type open. Building it costs a handful of allocations regardless of
+    // the entry count. Masks that cannot be answered from a single sorted run are either intersected from the
+    // permutations or evaluated with a vectorized scan over the columns (AVX2 or SSE2 when available).
+    class TgiIndex {
+    public:
+        void Build(std::span<const IndexEntry> entries);
+        void Clear();
+
+        // Position in the source index of the first entry with this TGI.
+        [[nodiscard]] std::optional<uint32_t> Find(const Tgi& tgi) const;
+        // Appends the positions in the source index of all entries matching the mask, in ascending order.
+        void FindMatching(const TgiMask& mask, std::vector<uint32_t>& out) const;
+
+        [[nodiscard]] size_t Size() const { return mPositions.size(); }
+        [[nodiscard]] bool Empty() const { return mPositions.empty(); }
+        [[nodiscard]] size_t MemoryUsage() const;
+
+    private:
+        struct RowRange {
+            uint32_t begin = 0;
+            uint32_t end = 0;
+        };
+
+        [[nodiscard]] static RowRange EqualRange(const std::vector<uint32_t>& column, RowRange rows, uint32_t value);
+        [[nodiscard]] static RowRange EqualRangeVia(const std::vector<uint32_t>& permutation,
+                                                    const std::vector<uint32_t>& column, uint32_t value);
+        void AppendMatching(const TgiMask& mask, std::vector<uint32_t>& out) const;
+        void AppendRows(RowRange rows, std::vector<uint32_t>& out) const;
+        void AppendRowsVia(const std::vector<uint32_t>& permutation, RowRange range, std::vector<uint32_t>& out) const;
+        void AppendIntersection(RowRange groupRange, RowRange instanceRange, std::vector<uint32_t>& out) const;
+        void AppendScanned(RowRange rows, const TgiMask& mask, std::vector<uint32_t>& out) const;
+
+        std::vector<uint32_t> mTypes;
+        std::vector<uint32_t> mGroups;
+        std::vector<uint32_t> mInstances;
+        std::vector<uint32_t> mPositions;
+        std::vector<uint32_t> mRowsByGroup;
+        std::vector<uint32_t> mRowsByInstance;
+    };
+
+} // namespace DBPF
@@ -0,0 +1,193 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace {
+
+    struct WorkerIdentity {
+        const DBPF::ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    thread_local WorkerIdentity tWorker;
+
+    constexpr size_t kNoWorker = static_cast<size_t>(-1);
+
+} // namespace
+
+namespace DBPF {
+
+    ThreadPool::ThreadPool(size_t threadCount) {
+        threadCount = std::max<size_t>(1, threadCount);
+        mQueues.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            mQueues.push_back(std::make_unique<WorkerQueue>());
+        }
+        mThreads.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            mThreads.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mWakeMutex);
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for (auto& thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    size_t ThreadPool::DefaultThreadCount() {
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    ThreadPool& ThreadPool::Shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    std::optional<size_t> ThreadPool::CurrentWorkerIndex() const {
+        if (tWorker.pool != this) {
+            return std::nullopt;
+        }
+        return tWorker.index;
+    }
+
+    void ThreadPool::Submit(Task task) {
+        const size_t target = tWorker.pool == this
+                                  ? tWorker.index
+                                  : mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+        {
+            // Count the task before publishing it so a worker that pops it can never underflow mPending.
+            std::lock_guard lock(mWakeMutex);
+            mPending.fetch_add(1, std::memory_order_release);
+        }
+        {
+            std::lock_guard lock(mQueues[target]->mutex);
+            mQueues[target]->tasks.push_back(std::move(task));
+        }
+        mWake.notify_one();
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (count == 0) {
+            return;
+        }
+        if (count == 1) {
+            fn(0);
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> remaining{0};
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;
+        };
+
+        const size_t chunkCount = std::min(count, Size() * 4);
+        const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+        auto state = std::make_shared<State>();
+        state->remaining.store((count + chunkSize - 1) / chunkSize, std::memory_order_relaxed);
+
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            const size_t end = std::min(count, begin + chunkSize);
+            Submit([state, &fn, begin, end] {
+                try {
+                    for (size_t i = begin; i < end; ++i) {
+                        fn(i);
+                    }
+                }
+                catch (...) {
+                    std::lock_guard lock(state->mutex);
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                }
+                std::lock_guard lock(state->mutex);
+                if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    state->done.notify_all();
+                }
+            });
+        }
+
+        const size_t self = tWorker.pool == this ? tWorker.index : kNoWorker;
+        while (state->remaining.load(std::memory_order_acquire) > 0) {
+            if (TryRunPending(self)) {
+                continue;
+            }
+            std::unique_lock lock(state->mutex);
+            state->done.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                return state->remaining.load(std::memory_order_acquire) == 0;
+            });
+        }
+
+        std::lock_guard lock(state->mutex);
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    void ThreadPool::WorkerLoop(const size_t index) {
+        tWorker = WorkerIdentity{this, index};
+        while (true) {
+            if (TryRunPending(index)) {
+                continue;
+            }
+            std::unique_lock lock(mWakeMutex);
+            mWake.wait(lock, [this] { return mStopping || mPending.load(std::memory_order_acquire) > 0; });
+            if (mStopping && mPending.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+
+    bool ThreadPool::TryPopLocal(const size_t index, Task& out) {
+        auto& queue = *mQueues[index];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        out = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool ThreadPool::TrySteal(const size_t thiefIndex, Task& out) {
+        const size_t queueCount = mQueues.size();
+        const size_t start = thiefIndex == kNoWorker ? 0 : thiefIndex + 1;
+        for (size_t offset = 0; offset < queueCount; ++offset) {
+            const size_t victim = (start + offset) % queueCount;
+            if (victim == thiefIndex) {
+                continue;
+            }
+            auto& queue = *mQueues[victim];
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            out = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool ThreadPool::TryRunPending(const size_t preferredIndex) {
+        Task task;
+        const bool found = (preferredIndex != kNoWorker && TryPopLocal(preferredIndex, task)) ||
+            TrySteal(preferredIndex, task);
+        if (!found) {
+            return false;
+        }
+        mPending.fetch_sub(1, std::memory_order_acq_rel);
+        task();
+        return true;
+    }
+
+} // namespace DBPF
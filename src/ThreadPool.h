@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace DBPF {
+
+    // Work-stealing pool: every worker owns a deque, runs its own most recent work first and steals the
+    // oldest work from other workers' deques when it runs dry.
+    class ThreadPool {
+    public:
+        using Task = std::function<void()>;
+
+        explicit ThreadPool(size_t threadCount = DefaultThreadCount());
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        [[nodiscard]] size_t Size() const { return mThreads.size(); }
+        // Index in [0, Size()) of the calling thread among this pool's workers, or nullopt for any other thread.
+        // Lets callers keep per-worker state without locking.
+        [[nodiscard]] std::optional<size_t> CurrentWorkerIndex() const;
+
+        void Submit(Task task);
+
+        // Runs fn(i) for every i in [0, count) and returns once all calls have finished. The calling thread
+        // helps with the work, so this may also be used from inside a pool task.
+        void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+        [[nodiscard]] static size_t DefaultThreadCount();
+        [[nodiscard]] static ThreadPool& Shared();
+
+    private:
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void WorkerLoop(size_t index);
+        bool TryPopLocal(size_t index, Task& out);
+        bool TrySteal(size_t thiefIndex, Task& out);
+        bool TryRunPending(size_t preferredIndex);
+
+        std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+        std::vector<std::thread> mThreads;
+        std::mutex mWakeMutex;
+        std::condition_variable mWake;
+        std::atomic<size_t> mPending{0};
+        std::atomic<size_t> mNextQueue{0};
+        bool mStopping = false;
+    };
+
+} // namespace DBPF
@@ -0,0 +1,150 @@
+#include "Trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <vector>
+
+namespace {
+
+    struct Event {
+        const char* category;
+        const char* name;
+        int64_t startNs;
+        int64_t durationNs;
+        uint64_t bytes;
+    };
+
+    // Only its own thread appends; the mutex is there for export and Clear.
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        uint32_t threadId = 0;
+    };
+
+    // Buffers are shared with the registry so events from threads that have exited are still exported.
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        uint32_t nextThreadId = 1;
+    };
+
+    std::atomic<bool> gRecording{false};
+
+    Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    int64_t NowNs() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    ThreadBuffer& LocalBuffer() {
+        thread_local const std::shared_ptr<ThreadBuffer> buffer = [] {
+            auto created = std::make_shared<ThreadBuffer>();
+            auto& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            created->threadId = registry.nextThreadId++;
+            registry.buffers.push_back(created);
+            return created;
+        }();
+        return *buffer;
+    }
+
+} // namespace
+
+namespace DBPF::Trace {
+
+    void Start() {
+        NowNs();
+        gRecording.store(true, std::memory_order_relaxed);
+    }
+
+    void Stop() {
+        gRecording.store(false, std::memory_order_relaxed);
+    }
+
+    bool IsRecording() {
+        return gRecording.load(std::memory_order_relaxed);
+    }
+
+    void Clear() {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            std::lock_guard bufferLock(buffer->mutex);
+            buffer->events.clear();
+            buffer->events.shrink_to_fit();
+        }
+    }
+
+    size_t EventCount() {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        size_t count = 0;
+        for (const auto& buffer : registry.buffers) {
+            std::lock_guard bufferLock(buffer->mutex);
+            count += buffer->events.size();
+        }
+        return count;
+    }
+
+    std::string ToChromeTraceJson() {
+        std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            std::lock_guard bufferLock(buffer->mutex);
+            for (const auto& event : buffer->events) {
+                json += first ? "\n" : ",\n";
+                first = false;
+                // Chrome expects microseconds; fractions keep the nanosecond resolution.
+                json += std::format("{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+                                    "\"pid\":1,\"tid\":{}",
+                                    event.name, event.category, static_cast<double>(event.startNs) / 1000.0,
+                                    static_cast<double>(event.durationNs) / 1000.0, buffer->threadId);
+                json += event.bytes != 0 ? std::format(",\"args\":{{\"bytes\":{}}}}}", event.bytes) : "}";
+            }
+        }
+        json += "\n]}\n";
+        return json;
+    }
+
+    bool WriteChromeTrace(const std::filesystem::path& path) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << ToChromeTraceJson();
+        if (!out) {
+            std::println("[Trace] Failed to write {}", path.string());
+            return false;
+        }
+        return true;
+    }
+
+    Scope::Scope(const char* category, const char* name, const uint64_t bytes)
+        : mCategory(category)
+        , mName(name)
+        , mBytes(bytes)
+        , mActive(IsRecording()) {
+        if (mActive) {
+            mStartNs = NowNs();
+        }
+    }
+
+    Scope::~Scope() {
+        if (!mActive) {
+            return;
+        }
+        const int64_t endNs = NowNs();
+        auto& buffer = LocalBuffer();
+        std::lock_guard lock(buffer.mutex);
+        buffer.events.push_back(Event{mCategory, mName, mStartNs, endNs - mStartNs, mBytes});
+    }
+
+} // namespace DBPF::Trace
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Timeline events for the load path, exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev). The
+// DBPFKIT_TRACE_SCOPE macros compile to nothing unless the library is built with DBPFKIT_ENABLE_TRACING; the
+// functions below always exist, so callers do not need their own #if.
+namespace DBPF::Trace {
+
+    // Events are only recorded between Start and Stop. Each thread appends to its own buffer, so recording on
+    // many threads at once does not contend.
+    void Start();
+    void Stop();
+    [[nodiscard]] bool IsRecording();
+    void Clear();
+    [[nodiscard]] size_t EventCount();
+
+    // Every event recorded so far, with timestamps relative to process start.
+    [[nodiscard]] std::string ToChromeTraceJson();
+    bool WriteChromeTrace(const std::filesystem::path& path);
+
+    // Records one complete event spanning its lifetime. category and name must be string literals that need no
+    // JSON escaping; bytes is shown as an argument when non-zero.
+    class Scope {
+    public:
+        Scope(const char* category, const char* name, uint64_t bytes = 0);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* mCategory;
+        const char* mName;
+        uint64_t mBytes;
+        int64_t mStartNs = 0;
+        bool mActive;
+    };
+
+} // namespace DBPF::Trace
+
+#define DBPFKIT_TRACE_CONCAT_INNER(a, b) a##b
+#define DBPFKIT_TRACE_CONCAT(a, b) DBPFKIT_TRACE_CONCAT_INNER(a, b)
+
+#if defined(DBPFKIT_ENABLE_TRACING) && DBPFKIT_ENABLE_TRACING
+#define DBPFKIT_TRACE_SCOPE(category, name) \
+    const ::DBPF::Trace::Scope DBPFKIT_TRACE_CONCAT(dbpfkitTraceScope, __LINE__)(category, name)
+#define DBPFKIT_TRACE_SCOPE_BYTES(category, name, bytes) \
+    const ::DBPF::Trace::Scope DBPFKIT_TRACE_CONCAT(dbpfkitTraceScope, __LINE__)(category, name, bytes)
+#else
+#define DBPFKIT_TRACE_SCOPE(category, name) static_cast<void>(0)
+#define DBPFKIT_TRACE_SCOPE_BYTES(category, name, bytes) static_cast<void>(0)
+#endif
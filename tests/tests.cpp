@@ -1,23 +1,43 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <initializer_list>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 
 #include "DBPFReader.h"
+#include "DBPFWriter.h"
 #include "DBPFStructures.h"
+#include "EntryCache.h"
 #include "ExemplarReader.h"
 #include "FSHReader.h"
+#include "IndexCache.h"
+#include "QFSCompressor.h"
 #include "QFSDecompressor.h"
 #include "LTextReader.h"
+#include "PluginSet.h"
+#include "PluginWatcher.h"
+#include "RecordCache.h"
 #include "RUL0.h"
+#include "S3DReader.h"
 #include "SafeSpanReader.h"
+#include "SyntheticCorpus.h"
+#include "TgiIndex.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 #include "squish/squish.h"
 
 namespace {
@@ -292,6 +312,44 @@ std::vector<uint8_t> BuildLTextBuffer(std::u16string_view text) {
     return buffer;
 }
 
+// Repetitive text with random bytes mixed in, so it compresses but not trivially.
+std::vector<uint8_t> CompressiblePayload(size_t size, uint32_t seed) {
+    static constexpr std::string_view kWords[] = {"Exemplar ", "Building ", "Lot ", "Prop ", "Texture ", "0x6534284A "};
+    std::vector<uint8_t> data;
+    data.reserve(size);
+    while (data.size() < size) {
+        seed = seed * 1664525u + 1013904223u;
+        if ((seed >> 28) == 0) {
+            data.push_back(static_cast<uint8_t>(seed >> 8));
+            continue;
+        }
+        const auto word = kWords[(seed >> 8) % std::size(kWords)];
+        data.insert(data.end(), word.begin(), word.end());
+    }
+    data.resize(size);
+    return data;
+}
+
+std::vector<uint8_t> RandomPayload(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+    return data;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+std::filesystem::path WriteTempFile(std::string_view name, const std::vector<uint8_t>& data) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    WriteFile(path, data);
+    return path;
+}
+
 } // namespace
 
 TEST_CASE("QFS decompressor matches reference literal handling") {
@@ -306,6 +364,118 @@ TEST_CASE("QFS decompressor matches reference literal handling") {
     REQUIRE(output == std::vector<uint8_t>{'S', 'C', '4', '!'});
 }
 
+TEST_CASE("QFS decompressor writes into caller-supplied storage") {
+    auto compressed = SampleQfsPayload();
+    std::span<const uint8_t> compressedSpan(compressed.data(), compressed.size());
+
+    std::array<uint8_t, 8> scratch{};
+    auto written = QFS::Decompressor::Decompress(compressedSpan, std::span<uint8_t>(scratch));
+    REQUIRE(written.has_value());
+    CHECK(*written == 4);
+    CHECK(std::equal(scratch.begin(), scratch.begin() + 4, std::string_view("SC4!").begin()));
+
+    std::array<uint8_t, 2> tooSmall{};
+    CHECK_FALSE(QFS::Decompressor::Decompress(compressedSpan, std::span<uint8_t>(tooSmall)).has_value());
+
+    std::array<std::byte, 256> arena{};
+    std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size());
+    std::pmr::vector<uint8_t> pmrOutput(&resource);
+    REQUIRE(QFS::Decompressor::Decompress(compressedSpan, pmrOutput).has_value());
+    CHECK(pmrOutput.size() == 4);
+    CHECK(pmrOutput.get_allocator().resource() == &resource);
+}
+
+TEST_CASE("QFS decompressor fast path handles short distances and stays in bounds") {
+    // Runs with every period from 1 to 40 exercise the pattern, 8, 16 and 32 byte copy paths.
+    std::vector<uint8_t> input;
+    for (size_t period = 1; period <= 40; ++period) {
+        const auto seed = RandomPayload(period, static_cast<uint32_t>(period));
+        for (size_t i = 0; i < 1500; ++i) {
+            input.push_back(seed[i % period]);
+        }
+        const auto noise = RandomPayload(37, static_cast<uint32_t>(period + 100));
+        input.insert(input.end(), noise.begin(), noise.end());
+    }
+    const auto compressed = QFS::Compressor::Compress(input);
+    REQUIRE(compressed.has_value());
+
+    constexpr size_t kGuard = 64;
+    std::vector<uint8_t> storage(input.size() + kGuard, 0xAA);
+    auto written = QFS::Decompressor::Decompress(*compressed, std::span<uint8_t>(storage.data(), input.size()));
+    REQUIRE(written.has_value());
+    CHECK(std::equal(input.begin(), input.end(), storage.begin()));
+    CHECK(std::all_of(storage.end() - kGuard, storage.end(), [](uint8_t byte) { return byte == 0xAA; }));
+
+    const auto truncated = std::span<const uint8_t>(*compressed).first(compressed->size() / 2);
+    std::vector<uint8_t> output;
+    CHECK_FALSE(QFS::Decompressor::Decompress(truncated, output).has_value());
+}
+
+TEST_CASE("QFS compressor output round-trips through the decompressor") {
+    std::vector<std::vector<uint8_t>> inputs{
+        {},
+        {'a'},
+        {'a', 'b', 'c', 'a', 'b', 'c', 'a'},
+        CompressiblePayload(5000, 1),
+        RandomPayload(3000, 2),
+        std::vector<uint8_t>(100000, 0x55),
+    };
+    // Repeats at distances that need the medium and long control forms.
+    for (const size_t distance : {2000u, 20000u, 70000u}) {
+        auto block = RandomPayload(distance, static_cast<uint32_t>(distance));
+        auto repeated = block;
+        repeated.insert(repeated.end(), block.begin(), block.begin() + 1500);
+        inputs.push_back(std::move(repeated));
+    }
+
+    using Level = QFS::Compressor::Level;
+    for (const auto level : {Level::kFast, Level::kDefault, Level::kOptimal}) {
+        for (const auto& input : inputs) {
+            auto compressed = QFS::Compressor::Compress(input, level);
+            REQUIRE(compressed.has_value());
+            REQUIRE(QFS::Decompressor::GetUncompressedSize(*compressed) == input.size());
+
+            std::vector<uint8_t> output;
+            auto result = QFS::Decompressor::Decompress(*compressed, output);
+            REQUIRE(result.has_value());
+            CHECK(output == input);
+        }
+    }
+
+    CHECK(QFS::Compressor::Compress(inputs[5])->size() < 2000);
+    CHECK(QFS::Compressor::Compress(inputs[7])->size() < inputs[7].size() - 1000);
+    CHECK_FALSE(QFS::Compressor::Compress(std::vector<uint8_t>(QFS::Compressor::kMaxInputSize + 1)).has_value());
+}
+
+TEST_CASE("QFS compressor levels trade speed for ratio and batch in order") {
+    using Level = QFS::Compressor::Level;
+    const auto input = CompressiblePayload(200000, 7);
+    const auto fast = QFS::Compressor::Compress(input, Level::kFast);
+    const auto balanced = QFS::Compressor::Compress(input, Level::kDefault);
+    const auto optimal = QFS::Compressor::Compress(input, Level::kOptimal);
+    REQUIRE(fast.has_value());
+    REQUIRE(balanced.has_value());
+    REQUIRE(optimal.has_value());
+    CHECK(balanced->size() <= fast->size());
+    CHECK(optimal->size() <= balanced->size());
+
+    std::vector<std::vector<uint8_t>> payloads;
+    for (uint32_t i = 0; i < 16; ++i) {
+        payloads.push_back(i % 4 == 0 ? RandomPayload(1000 + i, i) : CompressiblePayload(4000 + i * 31, i));
+    }
+    std::vector<std::span<const uint8_t>> spans(payloads.begin(), payloads.end());
+
+    DBPF::ThreadPool pool(3);
+    const auto results = QFS::Compressor::CompressBatch(spans, Level::kDefault, &pool);
+    REQUIRE(results.size() == payloads.size());
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        REQUIRE(results[i].has_value());
+        std::vector<uint8_t> output;
+        REQUIRE(QFS::Decompressor::Decompress(*results[i], output).has_value());
+        CHECK(output == payloads[i]);
+    }
+}
+
 TEST_CASE("DBPF reader parses uncompressed entries") {
     const DBPF::Tgi tgi{0x00000001, 0x00000002, 0x00000003};
     const std::vector<TestEntry> entries{
@@ -332,6 +502,30 @@ TEST_CASE("DBPF reader parses uncompressed entries") {
     REQUIRE(*data == std::vector<uint8_t>{'T', 'E', 'S', 'T'});
 }
 
+TEST_CASE("DBPF reader indexes borrowed and shared buffers without copying") {
+    const DBPF::Tgi tgi{0x00000001, 0x00000002, 0x00000003};
+    auto buffer = BuildDbpf({TestEntry{tgi, {'T', 'E', 'S', 'T'}}});
+
+    DBPF::Reader borrowed;
+    REQUIRE(borrowed.LoadBorrowedBuffer(buffer));
+    auto view = borrowed.ReadEntryView(tgi);
+    REQUIRE(view.has_value());
+    CHECK(view->Data().data() == buffer.data() + 0x60);
+    CHECK_FALSE(borrowed.LoadBorrowedBuffer(std::span<const uint8_t>(buffer.data(), 16)));
+
+    auto shared = std::shared_ptr<std::byte[]>(new std::byte[buffer.size()]);
+    std::memcpy(shared.get(), buffer.data(), buffer.size());
+    const auto* sharedBytes = reinterpret_cast<const uint8_t*>(shared.get());
+
+    DBPF::Reader owner;
+    REQUIRE(owner.LoadSharedBuffer(shared, buffer.size()));
+    shared.reset();
+    auto sharedView = owner.ReadEntryView(tgi);
+    REQUIRE(sharedView.has_value());
+    CHECK(sharedView->Data().data() == sharedBytes + 0x60);
+    CHECK(std::string_view(reinterpret_cast<const char*>(sharedView->Data().data()), sharedView->Size()) == "TEST");
+}
+
 TEST_CASE("DBPF reader decompresses QFS entries without directory metadata") {
     const DBPF::Tgi tgi{0x11111111, 0x22222222, 0x33333333};
     const std::vector<TestEntry> entries{
@@ -388,6 +582,1025 @@ TEST_CASE("DBPF reader applies directory metadata when present") {
     REQUIRE(*data == std::vector<uint8_t>{'S', 'C', '4', '!'});
 }
 
+TEST_CASE("DBPF reader packs its index with compression flags") {
+    const DBPF::Tgi plainTgi{0x01010101, 0x02020202, 0x03030303};
+    const DBPF::Tgi chunkedTgi{0x04040404, 0x05050505, 0x06060606};
+    auto probed = BuildDbpf({
+        TestEntry{plainTgi, {'R', 'A', 'W', '!', '!', '!'}},
+        TestEntry{chunkedTgi, WrapChunked(SampleQfsPayload(), 0x10)},
+    });
+
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadBuffer(probed.data(), probed.size()));
+    auto packed = reader.GetPackedIndex();
+    REQUIRE(packed.has_value());
+    REQUIRE(packed->size() == 2);
+    CHECK_FALSE((*packed)[1].IsCompressionKnown());
+    CHECK_FALSE((*packed)[1].IsCompressed());
+
+    packed = reader.GetPackedIndex(true);
+    REQUIRE(packed.has_value());
+    REQUIRE(packed->size() == 2);
+    CHECK((*packed)[0].IsCompressionKnown());
+    CHECK_FALSE((*packed)[0].IsCompressed());
+    CHECK((*packed)[1].IsCompressed());
+    CHECK_FALSE((*packed)[1].HasDecompressedSize());
+    CHECK((*packed)[0].Size() == 6);
+
+    const DBPF::Tgi dataTgi{0xAAAAAAAA, 0xBBBBBBBB, 0xCCCCCCCC};
+    auto withDirectory = BuildDbpf({
+        TestEntry{dataTgi, SampleQfsPayload()},
+        TestEntry{DBPF::kDirectoryTgi, BuildDirectoryPayload(dataTgi, 4)},
+    });
+    REQUIRE(reader.LoadBuffer(withDirectory.data(), withDirectory.size()));
+    packed = reader.GetPackedIndex();
+    REQUIRE(packed.has_value());
+    const auto& entry = (*packed)[0];
+    CHECK(entry.IsCompressionKnown());
+    CHECK(entry.IsCompressed());
+    CHECK(entry.DecompressedSize() == 4u);
+    CHECK(entry.GetSize() == 4);
+    CHECK_FALSE((*packed)[1].IsCompressed());
+
+    const auto unpacked = entry.Unpack();
+    const auto& original = reader.GetIndex()[0];
+    CHECK(unpacked.tgi == original.tgi);
+    CHECK(unpacked.offset == original.offset);
+    CHECK(unpacked.size == original.size);
+    CHECK(unpacked.decompressedSize == original.decompressedSize);
+
+    DBPF::IndexEntry huge;
+    huge.size = DBPF::PackedIndexEntry::kSizeMask + 1;
+    CHECK_FALSE(DBPF::PackedIndexEntry::Pack(huge, false).has_value());
+}
+
+TEST_CASE("DBPF reader reads mapped files in whole-file and per-range modes") {
+    const DBPF::Tgi plainTgi{0x00000001, 0x00000002, 0x00000003};
+    const DBPF::Tgi qfsTgi{0x11111111, 0x22222222, 0x33333333};
+    auto buffer = BuildDbpf({TestEntry{plainTgi, {'T', 'E', 'S', 'T'}}, TestEntry{qfsTgi, SampleQfsPayload()}});
+    const auto path = WriteTempFile("dbpfkit_mapping_modes.dat", buffer);
+
+    for (const auto mode : {io::MappedFile::MappingMode::kWholeFile, io::MappedFile::MappingMode::kPerRange,
+                            io::MappedFile::MappingMode::kNoMapping}) {
+        DBPF::Reader reader;
+        REQUIRE(reader.LoadFile(path, mode));
+        REQUIRE(reader.GetIndex().size() == 2);
+
+        auto plain = reader.ReadEntryData(plainTgi);
+        REQUIRE(plain.has_value());
+        CHECK(*plain == std::vector<uint8_t>{'T', 'E', 'S', 'T'});
+
+        auto decompressed = reader.ReadEntryData(qfsTgi);
+        REQUIRE(decompressed.has_value());
+        CHECK(*decompressed == std::vector<uint8_t>{'S', 'C', '4', '!'});
+    }
+
+    io::MappedFile file;
+    REQUIRE(file.Open(path));
+    CHECK(file.IsWholeFileMapped());
+    io::MappedFile::Range range;
+    REQUIRE(file.MapRange(0, 4, range));
+    CHECK(std::equal(range.View().begin(), range.View().end(), buffer.begin()));
+    CHECK_FALSE(file.MapRange(buffer.size() - 2, 4, range));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Mapped file serves positional and batched reads") {
+    std::vector<uint8_t> bytes(4096);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 31);
+    }
+    const auto path = WriteTempFile("dbpfkit_batched_reads.bin", bytes);
+
+    for (const auto mode : {io::MappedFile::MappingMode::kWholeFile, io::MappedFile::MappingMode::kPerRange,
+                            io::MappedFile::MappingMode::kNoMapping}) {
+        io::MappedFile file;
+        REQUIRE(file.Open(path, mode));
+        CHECK(file.UsesReadFallback() == (mode == io::MappedFile::MappingMode::kNoMapping));
+
+        std::array<uint8_t, 16> direct{};
+        REQUIRE(file.ReadAt(100, direct));
+        CHECK(std::equal(direct.begin(), direct.end(), bytes.begin() + 100));
+        CHECK_FALSE(file.ReadAt(bytes.size() - 8, direct));
+
+        std::array<io::MappedFile::RangeRequest, 4> requests;
+        requests[0].offset = 0;
+        requests[0].length = 64;
+        requests[1].offset = 3000;
+        requests[1].length = 1096;
+        requests[2].offset = 10;
+        requests[2].length = 0;
+        requests[3].offset = 4000;
+        requests[3].length = 200;
+
+        CHECK_FALSE(file.MapRanges(requests));
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(requests[i].ok);
+            const auto view = requests[i].range.View();
+            REQUIRE(view.size() == requests[i].length);
+            CHECK(std::equal(view.begin(), view.end(), bytes.begin() + static_cast<std::ptrdiff_t>(requests[i].offset)));
+        }
+        CHECK_FALSE(requests[3].ok);
+        CHECK(requests[3].range.Empty());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("DBPF reader returns zero-copy views for uncompressed entries") {
+    const DBPF::Tgi plainTgi{0x00000001, 0x00000002, 0x00000003};
+    const DBPF::Tgi qfsTgi{0x11111111, 0x22222222, 0x33333333};
+    auto buffer = BuildDbpf({TestEntry{plainTgi, {'T', 'E', 'S', 'T'}}, TestEntry{qfsTgi, SampleQfsPayload()}});
+    const auto path = WriteTempFile("dbpfkit_entry_view.dat", buffer);
+
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadFile(path));
+
+    auto first = reader.ReadEntryView(plainTgi);
+    auto second = reader.ReadEntryView(plainTgi);
+    REQUIRE(first.has_value());
+    REQUIRE(second.has_value());
+    CHECK_FALSE(first->IsDecompressed());
+    CHECK(first->Data().data() == second->Data().data());
+    CHECK(std::vector<uint8_t>(first->Data().begin(), first->Data().end()) == std::vector<uint8_t>{'T', 'E', 'S', 'T'});
+
+    auto decompressed = reader.ReadEntryView(qfsTgi);
+    REQUIRE(decompressed.has_value());
+    CHECK(decompressed->IsDecompressed());
+    CHECK(std::vector<uint8_t>(decompressed->Data().begin(), decompressed->Data().end()) ==
+          std::vector<uint8_t>{'S', 'C', '4', '!'});
+
+    CHECK_FALSE(reader.ReadEntryView(DBPF::Tgi{0xDEADBEEF, 0, 0}).has_value());
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("DBPF reader reads entries into a reusable scratch buffer") {
+    const DBPF::Tgi plainTgi{0x00000001, 0x00000002, 0x00000003};
+    const DBPF::Tgi qfsTgi{0x11111111, 0x22222222, 0x33333333};
+    auto buffer = BuildDbpf({
+        TestEntry{plainTgi, {'P', 'L', 'A', 'I', 'N'}},
+        TestEntry{qfsTgi, SampleQfsPayload()},
+        TestEntry{DBPF::kDirectoryTgi, BuildDirectoryPayload(qfsTgi, 4)},
+    });
+
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadBuffer(buffer.data(), buffer.size()));
+
+    std::vector<uint8_t> scratch(reader.GetLargestEntrySize());
+    const auto* plain = reader.FindEntry(plainTgi);
+    const auto* compressed = reader.FindEntry(qfsTgi);
+    REQUIRE(plain != nullptr);
+    REQUIRE(compressed != nullptr);
+
+    CHECK(reader.GetPayloadSize(*plain) == 5);
+    CHECK(reader.GetPayloadSize(*compressed) == 4);
+
+    auto plainSize = reader.ReadEntryInto(*plain, scratch);
+    REQUIRE(plainSize.has_value());
+    CHECK(std::string_view(reinterpret_cast<const char*>(scratch.data()), *plainSize) == "PLAIN");
+
+    auto compressedSize = reader.ReadEntryInto(*compressed, scratch);
+    REQUIRE(compressedSize.has_value());
+    CHECK(std::string_view(reinterpret_cast<const char*>(scratch.data()), *compressedSize) == "SC4!");
+
+    std::array<uint8_t, 2> tooSmall{};
+    CHECK_FALSE(reader.ReadEntryInto(*plain, tooSmall).has_value());
+
+    std::pmr::unsynchronized_pool_resource pool;
+    auto pmrData = reader.ReadEntryData(*compressed, &pool);
+    REQUIRE(pmrData.has_value());
+    CHECK(pmrData->size() == 4);
+    CHECK(pmrData->get_allocator().resource() == &pool);
+}
+
+TEST_CASE("DBPF reader supports concurrent const access and batch loading") {
+    std::vector<TestEntry> entries;
+    for (uint32_t i = 0; i < 64; ++i) {
+        std::vector<std::vector<uint8_t>> properties;
+        properties.push_back(MakeSingleUInt32Property(0x11111111, i));
+        entries.push_back(TestEntry{DBPF::Tgi{0x6534284A, 0x2821ED93, i}, BuildExemplarBuffer(properties)});
+        entries.push_back(TestEntry{DBPF::Tgi{0x11111111, 0x22222222, i}, SampleQfsPayload()});
+    }
+    auto buffer = BuildDbpf(entries);
+    const auto path = WriteTempFile("dbpfkit_concurrent.dat", buffer);
+
+    for (const auto mode : {io::MappedFile::MappingMode::kWholeFile, io::MappedFile::MappingMode::kPerRange,
+                            io::MappedFile::MappingMode::kNoMapping}) {
+        DBPF::Reader reader;
+        REQUIRE(reader.LoadFile(path, mode));
+
+        std::atomic<int> failures{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&, t] {
+                for (uint32_t i = 0; i < 64; ++i) {
+                    const uint32_t instance = (i + static_cast<uint32_t>(t) * 7) % 64;
+                    auto exemplar = reader.LoadExemplar(DBPF::Tgi{0x6534284A, 0x2821ED93, instance});
+                    if (!exemplar || exemplar->GetScalar<uint32_t>(0x11111111) != instance) {
+                        ++failures;
+                    }
+                    auto data = reader.ReadEntryData(DBPF::Tgi{0x11111111, 0x22222222, instance});
+                    if (!data || data->size() != 4) {
+                        ++failures;
+                    }
+                    if (reader.FindEntries(DBPF::TgiMask{0x6534284A, std::nullopt, std::nullopt}).size() != 64) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CHECK(failures.load() == 0);
+
+        std::vector<const DBPF::IndexEntry*> batch;
+        for (uint32_t i = 0; i < 64; ++i) {
+            batch.push_back(reader.FindEntry(DBPF::Tgi{0x6534284A, 0x2821ED93, 63 - i}));
+        }
+        batch.push_back(nullptr);
+
+        DBPF::ThreadPool pool(4);
+        auto exemplars = reader.LoadExemplars(batch, &pool);
+        REQUIRE(exemplars.size() == batch.size());
+        for (uint32_t i = 0; i < 64; ++i) {
+            REQUIRE(exemplars[i].has_value());
+            CHECK(exemplars[i]->GetScalar<uint32_t>(0x11111111) == 63 - i);
+        }
+        CHECK_FALSE(exemplars.back().has_value());
+
+        auto raw = reader.ReadEntries(batch, &pool);
+        REQUIRE(raw.size() == batch.size());
+        CHECK(raw.front().has_value());
+        CHECK_FALSE(raw.back().has_value());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("DBPF reader decodes batches with per-worker scratch buffers") {
+    const auto path = std::filesystem::temp_directory_path() / "dbpfkit_decode_batch.dat";
+    std::vector<std::vector<uint8_t>> payloads;
+    {
+        DBPF::ThreadPool pool(2);
+        DBPF::Writer writer(&pool);
+        REQUIRE(writer.Open(path));
+        for (uint32_t i = 0; i < 96; ++i) {
+            payloads.push_back(i % 3 == 0 ? RandomPayload(500 + i * 13, i) : CompressiblePayload(2000 + i * 517, i));
+            REQUIRE(writer.Add(DBPF::Tgi{0x7AB50E44, 0x1ABE787D, i}, std::span<const uint8_t>(payloads.back()),
+                               i % 3 != 0));
+        }
+        REQUIRE(writer.Finish());
+    }
+
+    for (const auto mode : {io::MappedFile::MappingMode::kWholeFile, io::MappedFile::MappingMode::kNoMapping}) {
+        DBPF::Reader reader;
+        REQUIRE(reader.LoadFile(path, mode));
+        std::vector<const DBPF::IndexEntry*> batch;
+        for (uint32_t i = 0; i < payloads.size(); ++i) {
+            batch.push_back(reader.FindEntry(DBPF::Tgi{0x7AB50E44, 0x1ABE787D, i}));
+        }
+
+        DBPF::ThreadPool pool(4);
+        std::vector<std::vector<uint8_t>> decoded(batch.size());
+        std::atomic<int> wrongEntry{0};
+        REQUIRE(reader.DecodeEntries(batch, [&](size_t index, const DBPF::IndexEntry& entry,
+                                                std::span<const uint8_t> payload) {
+            if (&entry != batch[index]) {
+                ++wrongEntry;
+            }
+            decoded[index].assign(payload.begin(), payload.end());
+        }, &pool));
+        CHECK(wrongEntry.load() == 0);
+        CHECK(decoded == payloads);
+
+        // While the visitor waits on its own ParallelFor it may run sibling items of the batch on the same thread;
+        // those must not reuse the scratch its payload still points into.
+        std::atomic<int> clobbered{0};
+        REQUIRE(reader.DecodeEntries(batch, [&](size_t index, const DBPF::IndexEntry&,
+                                                std::span<const uint8_t> payload) {
+            std::atomic<size_t> nested{0};
+            pool.ParallelFor(16, [&](size_t) { ++nested; });
+            if (!std::ranges::equal(payload, payloads[index])) {
+                ++clobbered;
+            }
+        }, &pool));
+        CHECK(clobbered.load() == 0);
+
+        batch.push_back(nullptr);
+        std::atomic<int> visited{0};
+        CHECK_FALSE(reader.DecodeEntries(batch, [&](size_t, const DBPF::IndexEntry&, std::span<const uint8_t>) {
+            ++visited;
+        }, &pool));
+        CHECK(visited.load() == static_cast<int>(payloads.size()));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Entry cache evicts least recently used payloads within its byte budget") {
+    DBPF::EntryCache cache(100);
+    const DBPF::Tgi a{1, 1, 1};
+    const DBPF::Tgi b{1, 1, 2};
+    const DBPF::Tgi c{1, 1, 3};
+
+    CHECK(cache.Find(a) == nullptr);
+    cache.Insert(a, std::vector<uint8_t>(40, 'a'));
+    const auto heldB = cache.Insert(b, std::vector<uint8_t>(40, 'b'));
+    REQUIRE(cache.Find(a) != nullptr);
+    cache.Insert(c, std::vector<uint8_t>(40, 'c'));
+
+    CHECK(cache.Find(b) == nullptr);
+    CHECK(heldB->size() == 40);
+    CHECK(cache.Find(a)->front() == 'a');
+    CHECK(cache.Find(c) != nullptr);
+
+    const auto oversized = cache.Insert(DBPF::Tgi{1, 1, 4}, std::vector<uint8_t>(101));
+    CHECK(oversized->size() == 101);
+    CHECK(cache.Find(DBPF::Tgi{1, 1, 4}) == nullptr);
+
+    auto stats = cache.GetStats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.misses == 3);
+    CHECK(stats.evictions == 1);
+    CHECK(stats.entryCount == 2);
+    CHECK(stats.bytes == 80);
+
+    cache.SetCapacity(50);
+    stats = cache.GetStats();
+    CHECK(stats.entryCount == 1);
+    CHECK(stats.evictions == 2);
+    cache.ResetStats();
+    CHECK(cache.GetStats().hits == 0);
+}
+
+TEST_CASE("DBPF reader serves repeated reads from the entry cache") {
+    const auto path = std::filesystem::temp_directory_path() / "dbpfkit_entry_cache.dat";
+    const auto payload = CompressiblePayload(20000, 3);
+    {
+        DBPF::Writer writer;
+        REQUIRE(writer.Open(path));
+        REQUIRE(writer.Add(DBPF::Tgi{0x7AB50E44, 0x1ABE787D, 1}, std::span<const uint8_t>(payload), true));
+        REQUIRE(writer.Add(DBPF::Tgi{0x7AB50E44, 0x1ABE787D, 2}, std::span<const uint8_t>(payload), false));
+        REQUIRE(writer.Finish());
+    }
+
+    DBPF::Reader reader;
+    reader.SetEntryCacheCapacity(1024 * 1024);
+    REQUIRE(reader.LoadFile(path));
+    const DBPF::Tgi compressed{0x7AB50E44, 0x1ABE787D, 1};
+
+    const auto first = reader.ReadEntryShared(compressed);
+    const auto second = reader.ReadEntryShared(compressed);
+    REQUIRE(first != nullptr);
+    CHECK(*first == payload);
+    CHECK(first == second);
+    CHECK(reader.ReadEntryData(compressed) == payload);
+    CHECK(reader.ReadEntryView(compressed)->Data().data() == first->data());
+
+    // Uncompressed payloads are served straight from the mapping and never take up cache space.
+    CHECK(*reader.ReadEntryShared(DBPF::Tgi{0x7AB50E44, 0x1ABE787D, 2}) == payload);
+    auto stats = reader.GetEntryCache()->GetStats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.entryCount == 1);
+    CHECK(stats.bytes == payload.size());
+
+    // Reads of an uncompressed entry never consult the cache, so they do not count as misses either.
+    const auto missesBefore = stats.misses;
+    for (int i = 0; i < 4; ++i) {
+        CHECK(reader.ReadEntryView(DBPF::Tgi{0x7AB50E44, 0x1ABE787D, 2})->Size() == payload.size());
+    }
+    CHECK(reader.GetEntryCache()->GetStats().misses == missesBefore);
+
+    REQUIRE(reader.LoadFile(path));
+    CHECK(reader.GetEntryCache()->GetStats().entryCount == 0);
+    CHECK(*first == payload);
+
+    reader.SetEntryCacheCapacity(0);
+    CHECK(reader.GetEntryCache() == nullptr);
+    CHECK(reader.ReadEntryData(compressed) == payload);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Entry cache looks up only compressed entries in archives without a directory") {
+    const DBPF::Tgi plainTgi{0x01010101, 0x02020202, 0x03030303};
+    const DBPF::Tgi qfsTgi{0x11111111, 0x22222222, 0x33333333};
+    auto buffer = BuildDbpf({TestEntry{plainTgi, {'R', 'A', 'W'}}, TestEntry{qfsTgi, SampleQfsPayload()}});
+
+    DBPF::Reader reader;
+    reader.SetEntryCacheCapacity(1024 * 1024);
+    REQUIRE(reader.LoadBuffer(buffer.data(), buffer.size()));
+    REQUIRE_FALSE(reader.HasDirectory());
+
+    for (int i = 0; i < 3; ++i) {
+        CHECK(reader.ReadEntryData(plainTgi) == std::vector<uint8_t>{'R', 'A', 'W'});
+        CHECK(reader.ReadEntryData(qfsTgi) == std::vector<uint8_t>{'S', 'C', '4', '!'});
+    }
+    const auto stats = reader.GetEntryCache()->GetStats();
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 2);
+    CHECK(stats.entryCount == 1);
+}
+
+TEST_CASE("DBPF reader statistics count I/O, decompression and typed loads") {
+    const auto path = std::filesystem::temp_directory_path() / "dbpfkit_reader_stats.dat";
+    const auto payload = CompressiblePayload(20000, 5);
+    Synthetic::Rng rng(9);
+    const auto exemplar = Synthetic::MakeExemplar(rng, 12);
+    const DBPF::Tgi exemplarTgi{0x6534284A, 0x11111111, 1};
+    const DBPF::Tgi compressedTgi{0x6534284A, 0x11111111, 2};
+    {
+        DBPF::Writer writer;
+        REQUIRE(writer.Open(path));
+        REQUIRE(writer.Add(exemplarTgi, std::span<const uint8_t>(exemplar), false));
+        REQUIRE(writer.Add(compressedTgi, std::span<const uint8_t>(payload), true));
+        REQUIRE(writer.Finish());
+    }
+
+    DBPF::Reader reader;
+    CHECK(reader.GetStats() == nullptr);
+    reader.SetStatsEnabled(true);
+    REQUIRE(reader.LoadFile(path));
+    auto* stats = reader.GetStats();
+    REQUIRE(stats != nullptr);
+    CHECK(stats->GetSnapshot().bytesMapped > 0);
+
+    CHECK(reader.LoadExemplar(exemplarTgi).has_value());
+    CHECK_FALSE(reader.LoadExemplar(compressedTgi).has_value());
+    CHECK(reader.ReadEntryData(compressedTgi) == payload);
+    auto snapshot = stats->GetSnapshot();
+    const auto& exemplars = snapshot.Get(DBPF::ReaderStats::Parser::kExemplar);
+    CHECK(exemplars.calls == 2);
+    CHECK(exemplars.failures == 1);
+    CHECK(exemplars.nanoseconds > 0);
+    CHECK(snapshot.Get(DBPF::ReaderStats::Parser::kFSH).calls == 0);
+    CHECK(snapshot.entriesDecompressed == 2);
+    CHECK(snapshot.qfsBytesOut == 2 * payload.size());
+    CHECK(snapshot.qfsBytesIn > 0);
+    CHECK(snapshot.qfsBytesIn < snapshot.qfsBytesOut);
+    CHECK(snapshot.bytesReadFallback == 0);
+    CHECK(snapshot.readFailures == 0);
+    CHECK(snapshot.decompressFailures == 0);
+
+    CHECK(stats->TakeSnapshot().entriesDecompressed == 2);
+    CHECK(stats->GetSnapshot().entriesDecompressed == 0);
+
+    // Without a mapping every byte arrives through positional reads.
+    REQUIRE(reader.LoadFile(path, io::MappedFile::MappingMode::kNoMapping));
+    CHECK(reader.ReadEntryData(compressedTgi) == payload);
+    snapshot = stats->GetSnapshot();
+    CHECK(snapshot.bytesMapped == 0);
+    CHECK(snapshot.bytesReadFallback > snapshot.qfsBytesIn);
+    CHECK(snapshot.entriesDecompressed == 1);
+
+    stats->Reset();
+    CHECK(stats->GetSnapshot().bytesReadFallback == 0);
+    reader.SetStatsEnabled(false);
+    CHECK(reader.GetStats() == nullptr);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Trace sink exports scoped events as Chrome trace JSON") {
+    const auto path = std::filesystem::temp_directory_path() / "dbpfkit_trace.dat";
+    const auto tracePath = std::filesystem::temp_directory_path() / "dbpfkit_trace.json";
+    Synthetic::Rng rng(4);
+    const auto exemplar = Synthetic::MakeTextExemplar(rng, 60);
+    const DBPF::Tgi tgi{0x6534284A, 0x11111111, 1};
+    {
+        DBPF::Writer writer;
+        REQUIRE(writer.Open(path));
+        REQUIRE(writer.Add(tgi, std::span<const uint8_t>(exemplar), true));
+        REQUIRE(writer.Finish());
+    }
+
+    DBPF::Trace::Clear();
+    DBPF::Trace::Start();
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadFile(path));
+    REQUIRE(reader.IsCompressed(*reader.FindEntry(tgi)));
+    CHECK(reader.LoadExemplar(tgi).has_value());
+    {
+        const DBPF::Trace::Scope scope("test", "Manual", 7);
+    }
+    DBPF::Trace::Stop();
+
+    const auto json = DBPF::Trace::ToChromeTraceJson();
+    CHECK(json.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    CHECK(json.ends_with("]}\n"));
+    CHECK(json.find("\"name\":\"Manual\",\"cat\":\"test\",\"ph\":\"X\"") != std::string::npos);
+    CHECK(json.find("\"args\":{\"bytes\":7}") != std::string::npos);
+#if defined(DBPFKIT_ENABLE_TRACING) && DBPFKIT_ENABLE_TRACING
+    for (const char* name : {"LoadFile", "ParseHeader", "ParseIndexSpan", "ApplyDirectoryMetadata", "MapRange",
+                             "QFS::Decompress", "Exemplar::Parse"}) {
+        INFO(name);
+        CHECK(json.find(std::string("\"name\":\"") + name + "\"") != std::string::npos);
+    }
+#else
+    CHECK(DBPF::Trace::EventCount() == 1);
+#endif
+
+    // Nothing is recorded once stopped.
+    const size_t count = DBPF::Trace::EventCount();
+    CHECK(reader.LoadExemplar(tgi).has_value());
+    CHECK(DBPF::Trace::EventCount() == count);
+
+    REQUIRE(DBPF::Trace::WriteChromeTrace(tracePath));
+    CHECK(std::filesystem::file_size(tracePath) == json.size());
+    DBPF::Trace::Clear();
+    CHECK(DBPF::Trace::EventCount() == 0);
+    std::filesystem::remove(path);
+    std::filesystem::remove(tracePath);
+}
+
+TEST_CASE("Record cache shares parsed records and parses each TGI once") {
+    std::vector<TestEntry> entries;
+    for (uint32_t i = 0; i < 4; ++i) {
+        std::vector<std::vector<uint8_t>> properties;
+        properties.push_back(MakeSingleUInt32Property(0x11111111, i));
+        entries.push_back(TestEntry{DBPF::Tgi{0x6534284A, 0x2821ED93, i}, BuildExemplarBuffer(properties)});
+    }
+    auto buffer = BuildDbpf(entries);
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadBuffer(buffer.data(), buffer.size()));
+
+    // A slow source makes the concurrent requests overlap with the first parse.
+    std::atomic<int> sourceCalls{0};
+    DBPF::RecordCache cache([&](const DBPF::Tgi& tgi) {
+        ++sourceCalls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return reader.ReadEntryView(tgi);
+    });
+
+    const DBPF::Tgi tgi{0x6534284A, 0x2821ED93, 2};
+    std::vector<std::shared_ptr<const Exemplar::Record>> results(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&, t] {
+            auto record = cache.LoadExemplar(tgi);
+            if (record) {
+                results[t] = *record;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(sourceCalls.load() == 1);
+    REQUIRE(results.front() != nullptr);
+    CHECK(results.front()->GetScalar<uint32_t>(0x11111111) == 2u);
+    CHECK(std::all_of(results.begin(), results.end(), [&](const auto& record) { return record == results.front(); }));
+
+    using RecordType = DBPF::RecordCache::RecordType;
+    auto stats = cache.GetStats(RecordType::kExemplar);
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 7);
+    CHECK(stats.recordCount == 1);
+    CHECK(stats.bytes > sizeof(Exemplar::Record));
+    CHECK(cache.MemoryUsage() == stats.bytes);
+    CHECK(cache.GetStats(RecordType::kFSH).bytes == 0);
+
+    // Failures reach the caller but are not kept.
+    const DBPF::Tgi missing{0x6534284A, 0x2821ED93, 99};
+    CHECK_FALSE(cache.LoadExemplar(missing).has_value());
+    CHECK_FALSE(cache.LoadExemplar(missing).has_value());
+    stats = cache.GetStats(RecordType::kExemplar);
+    CHECK(stats.failures == 2);
+    CHECK(stats.recordCount == 1);
+
+    cache.Erase(tgi);
+    CHECK(cache.MemoryUsage() == 0);
+    auto reloaded = cache.LoadExemplar(tgi);
+    REQUIRE(reloaded.has_value());
+    CHECK(*reloaded != results.front());
+    CHECK(sourceCalls.load() == 4);
+}
+
+TEST_CASE("DBPF reader prefetches entries before reading them") {
+    std::vector<TestEntry> entries;
+    for (uint32_t i = 0; i < 16; ++i) {
+        entries.push_back(TestEntry{DBPF::Tgi{0x7AB50E44, 0x1ABE787D, i}, std::vector<uint8_t>(1000 + i, static_cast<uint8_t>(i))});
+    }
+    auto buffer = BuildDbpf(entries);
+    const auto path = WriteTempFile("dbpfkit_prefetch.dat", buffer);
+
+    for (const auto mode : {io::MappedFile::MappingMode::kWholeFile, io::MappedFile::MappingMode::kPerRange,
+                            io::MappedFile::MappingMode::kNoMapping}) {
+        DBPF::Reader reader;
+        REQUIRE(reader.LoadFile(path, mode));
+
+        auto planned = reader.FindEntries(DBPF::TgiMask{0x7AB50E44, std::nullopt, std::nullopt});
+        REQUIRE(planned.size() == 16);
+        reader.Prefetch(planned);
+        auto pending = reader.PrefetchAsync(planned);
+        pending.get();
+
+        for (const auto* entry : planned) {
+            auto data = reader.ReadEntryData(*entry);
+            REQUIRE(data.has_value());
+            CHECK(data->size() == 1000 + entry->tgi.instance);
+        }
+    }
+
+    DBPF::Reader bufferReader;
+    REQUIRE(bufferReader.LoadBuffer(buffer.data(), buffer.size()));
+    bufferReader.Prefetch(bufferReader.FindEntries(DBPF::TgiMask{}));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("DBPF reader streams entries in file order") {
+    std::vector<TestEntry> entries;
+    for (uint32_t i = 0; i < 32; ++i) {
+        const size_t size = i == 7 ? 200 * 1024 : 5000 + i;
+        entries.push_back(TestEntry{DBPF::Tgi{0x11111111, 0x22222222, i}, std::vector<uint8_t>(size, static_cast<uint8_t>(i))});
+    }
+    entries.push_back(TestEntry{DBPF::Tgi{0x33333333, 0x44444444, 0x55555555}, SampleQfsPayload()});
+    auto buffer = BuildDbpf(entries);
+
+    // Reverse the on-disk index order so index order and file order disagree.
+    constexpr size_t kIndexRecordSize = 20;
+    const size_t indexOffset = buffer.size() - entries.size() * kIndexRecordSize;
+    for (size_t lo = 0, hi = entries.size() - 1; lo < hi; ++lo, --hi) {
+        std::swap_ranges(buffer.begin() + static_cast<std::ptrdiff_t>(indexOffset + lo * kIndexRecordSize),
+                         buffer.begin() + static_cast<std::ptrdiff_t>(indexOffset + (lo + 1) * kIndexRecordSize),
+                         buffer.begin() + static_cast<std::ptrdiff_t>(indexOffset + hi * kIndexRecordSize));
+    }
+    const auto path = WriteTempFile("dbpfkit_file_order.dat", buffer);
+
+    auto verify = [&](const DBPF::Reader& reader) {
+        CHECK(reader.GetIndex().front().tgi.instance == 0x55555555);
+
+        std::vector<uint32_t> offsets;
+        bool sawDecompressed = false;
+        CHECK(reader.ForEachEntryInFileOrder([&](const DBPF::IndexEntry& entry, std::span<const uint8_t> payload) {
+            offsets.push_back(entry.offset);
+            if (entry.tgi.type == 0x33333333) {
+                sawDecompressed = std::string_view(reinterpret_cast<const char*>(payload.data()), payload.size()) == "SC4!";
+            }
+            else {
+                const bool intact = payload.size() == entries[entry.tgi.instance].data.size() &&
+                    std::ranges::all_of(payload, [&](uint8_t b) { return b == entry.tgi.instance; });
+                CHECK(intact);
+            }
+            return true;
+        }, 64 * 1024));
+        CHECK(offsets.size() == entries.size());
+        CHECK(std::ranges::is_sorted(offsets));
+        CHECK(sawDecompressed);
+
+        size_t visited = 0;
+        reader.ForEachEntryInFileOrder([&](const DBPF::IndexEntry&, std::span<const uint8_t>) { return ++visited < 3; });
+        CHECK(visited == 3);
+    };
+
+    for (const auto mode : {io::MappedFile::MappingMode::kWholeFile, io::MappedFile::MappingMode::kNoMapping}) {
+        DBPF::Reader reader;
+        REQUIRE(reader.LoadFile(path, mode));
+        verify(reader);
+    }
+    DBPF::Reader bufferReader;
+    REQUIRE(bufferReader.LoadBuffer(buffer.data(), buffer.size()));
+    verify(bufferReader);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Plugin set resolves TGIs in load order") {
+    const auto root = std::filesystem::temp_directory_path() / "dbpfkit_plugin_set";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "sub");
+
+    const DBPF::Tgi shared{0x6534284A, 0x11111111, 0x1};
+    const DBPF::Tgi onlyFirst{0x6534284A, 0x11111111, 0x2};
+    WriteFile(root / "b.dat", BuildDbpf({TestEntry{shared, {'B'}}}));
+    WriteFile(root / "A.dat", BuildDbpf({TestEntry{shared, {'A'}}, TestEntry{onlyFirst, {'A'}}}));
+    WriteFile(root / "sub" / "a.SC4Lot", BuildDbpf({TestEntry{shared, {'S'}}}));
+    WriteFile(root / "broken.dat", {'n', 'o', 'p', 'e'});
+    WriteFile(root / "notes.txt", {'x'});
+
+    const auto files = DBPF::PluginSet::CollectPluginFiles(root);
+    REQUIRE(files.size() == 4);
+    CHECK(files[0].filename() == "A.dat");
+    CHECK(files[1].filename() == "b.dat");
+    CHECK(files[2].filename() == "broken.dat");
+    CHECK(files[3].filename() == "a.SC4Lot");
+
+    DBPF::ThreadPool pool(2);
+    DBPF::PluginSet plugins;
+    const std::array roots{root};
+    CHECK(plugins.LoadDirectories(roots, &pool) == 3);
+    REQUIRE(plugins.GetFailedFiles().size() == 1);
+    CHECK(plugins.GetFailedFiles()[0].filename() == "broken.dat");
+    CHECK(plugins.EntryCount() == 2);
+
+    CHECK(plugins.ReadEntryData(shared) == std::vector<uint8_t>{'S'});
+    CHECK(plugins.ReadEntryData(onlyFirst) == std::vector<uint8_t>{'A'});
+    const auto location = plugins.Find(shared);
+    REQUIRE(location.has_value());
+    CHECK(plugins.GetArchivePath(location->archive).filename() == "a.SC4Lot");
+
+    DBPF::TgiMask mask;
+    mask.group = 0x11111111;
+    const auto matches = plugins.FindEntries(mask);
+    REQUIRE(matches.size() == 2);
+    CHECK(matches[0].entry->tgi == onlyFirst);
+    CHECK(matches[1].entry->tgi == shared);
+
+    CHECK_FALSE(plugins.LoadExemplar(DBPF::Tgi{1, 2, 3}).has_value());
+    std::filesystem::remove_all(root);
+}
+
+#ifdef __linux__
+TEST_CASE("Plugin watcher patches the winner table as files change") {
+    const auto root = std::filesystem::temp_directory_path() / "dbpfkit_plugin_watcher";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    const DBPF::Tgi shared{0x6534284A, 0x22222222, 0x1};
+    const DBPF::Tgi other{0x6534284A, 0x22222222, 0x2};
+    WriteFile(root / "base.dat", BuildDbpf({TestEntry{shared, {'A'}}, TestEntry{other, {'O'}}}));
+
+    DBPF::ThreadPool pool(2);
+    DBPF::PluginSet plugins;
+    const std::array roots{root};
+    REQUIRE(plugins.LoadDirectories(roots, &pool) == 1);
+
+    DBPF::PluginWatcher watcher(plugins, &pool);
+    REQUIRE(watcher.Start());
+    std::vector<DBPF::Tgi> feed;
+    watcher.Subscribe([&](std::span<const DBPF::Tgi> changed) { feed.assign(changed.begin(), changed.end()); });
+    CHECK(watcher.Poll() == 0);
+
+    std::filesystem::create_directories(root / "zz");
+    WriteFile(root / "zz" / "override.dat", BuildDbpf({TestEntry{shared, {'Z'}}}));
+    CHECK(watcher.Poll(1000) == 1);
+    CHECK(feed == std::vector<DBPF::Tgi>{shared});
+    CHECK(plugins.ArchiveCount() == 2);
+    CHECK(plugins.ReadEntryData(shared) == std::vector<uint8_t>{'Z'});
+
+    WriteFile(root / "base.dat", BuildDbpf({TestEntry{shared, {'B'}}, TestEntry{other, {'P'}}}));
+    CHECK(watcher.Poll(1000) == 1);
+    CHECK(feed == std::vector<DBPF::Tgi>{other});
+    CHECK(plugins.ReadEntryData(other) == std::vector<uint8_t>{'P'});
+
+    std::filesystem::remove(root / "zz" / "override.dat");
+    CHECK(watcher.Poll(1000) == 1);
+    CHECK(feed == std::vector<DBPF::Tgi>{shared});
+    CHECK(plugins.ArchiveCount() == 1);
+    CHECK(plugins.ReadEntryData(shared) == std::vector<uint8_t>{'B'});
+
+    watcher.Stop();
+    std::filesystem::remove_all(root);
+}
+#endif
+
+TEST_CASE("Index cache skips parsing for unchanged archives") {
+    const auto root = std::filesystem::temp_directory_path() / "dbpfkit_index_cache";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    const auto cacheFile = root / "index.cache";
+
+    const DBPF::Tgi dataTgi{0xAAAAAAAA, 0xBBBBBBBB, 0xCCCCCCCC};
+    const DBPF::Tgi plainTgi{0x01010101, 0x02020202, 0x03030303};
+    const auto first = root / "first.dat";
+    const auto second = root / "second.dat";
+    WriteFile(first, BuildDbpf({TestEntry{dataTgi, SampleQfsPayload()},
+                                TestEntry{DBPF::kDirectoryTgi, BuildDirectoryPayload(dataTgi, 4)}}));
+    WriteFile(second, BuildDbpf({TestEntry{plainTgi, {'P', 'L', 'A', 'I', 'N'}}}));
+
+    DBPF::ThreadPool pool(2);
+    const std::array roots{root};
+    DBPF::PluginSet plugins;
+    REQUIRE(plugins.LoadDirectories(roots, &pool) == 2);
+    REQUIRE(plugins.SaveIndexCache(cacheFile));
+
+    DBPF::IndexCache cache;
+    REQUIRE(cache.Open(cacheFile));
+    CHECK(cache.ArchiveCount() == 2);
+
+    const auto cached = cache.Lookup(first);
+    REQUIRE(cached.has_value());
+    CHECK(cached->hasDirectory);
+    REQUIRE(cached->entries.size() == 2);
+    CHECK(cached->entries[0].IsCompressed());
+    CHECK(cached->entries[0].DecompressedSize() == 4u);
+
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadFile(first, *cached));
+    CHECK(reader.GetHeader().indexEntryCount == 2);
+    CHECK(reader.ReadEntryData(dataTgi) == std::vector<uint8_t>{'S', 'C', '4', '!'});
+
+    DBPF::PluginSet fromCache;
+    REQUIRE(fromCache.LoadDirectories(roots, &pool, &cache) == 2);
+    CHECK(fromCache.GetCacheHitCount() == 2);
+    CHECK(fromCache.ReadEntryData(plainTgi) == std::vector<uint8_t>{'P', 'L', 'A', 'I', 'N'});
+
+    {
+        std::ofstream out(second, std::ios::binary | std::ios::app);
+        out.put('\0');
+    }
+    CHECK_FALSE(cache.Lookup(second).has_value());
+    REQUIRE(fromCache.LoadDirectories(roots, &pool, &cache) == 2);
+    CHECK(fromCache.GetCacheHitCount() == 1);
+
+    cache.Close();
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Index cache rejects records whose offsets wrap around") {
+    const auto root = std::filesystem::temp_directory_path() / "dbpfkit_index_cache_corrupt";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    const auto cacheFile = root / "index.cache";
+
+    const DBPF::Tgi plainTgi{0x01010101, 0x02020202, 0x03030303};
+    WriteFile(root / "plain.dat", BuildDbpf({TestEntry{plainTgi, {'P'}}}));
+    const std::array roots{root};
+    DBPF::PluginSet plugins;
+    REQUIRE(plugins.LoadDirectories(roots) == 1);
+    REQUIRE(plugins.SaveIndexCache(cacheFile));
+
+    std::vector<uint8_t> original(std::filesystem::file_size(cacheFile));
+    {
+        std::ifstream in(cacheFile, std::ios::binary);
+        in.read(reinterpret_cast<char*>(original.data()), static_cast<std::streamsize>(original.size()));
+    }
+
+    // The first archive record follows the 16-byte file header; pathOffset and entriesOffset sit at 16 and 24.
+    constexpr size_t kPathOffset = 16 + 16;
+    constexpr size_t kEntriesOffset = 16 + 24;
+    for (const size_t field : {kPathOffset, kEntriesOffset}) {
+        auto corrupt = original;
+        const uint64_t huge = std::numeric_limits<uint64_t>::max() - 7;
+        std::memcpy(corrupt.data() + field, &huge, sizeof(huge));
+        WriteFile(cacheFile, corrupt);
+
+        DBPF::IndexCache cache;
+        CHECK_FALSE(cache.Open(cacheFile));
+        CHECK(cache.ArchiveCount() == 0);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("DBPF writer output round-trips through the reader") {
+    const auto path = std::filesystem::temp_directory_path() / "dbpfkit_writer.dat";
+    std::vector<std::pair<DBPF::Tgi, std::vector<uint8_t>>> entries;
+    for (uint32_t i = 0; i < 40; ++i) {
+        const DBPF::Tgi tgi{0x6534284A, 0x33333333, i};
+        entries.emplace_back(tgi, i % 5 == 0 ? RandomPayload(700 + i, i) : CompressiblePayload(300 + i * 97, i));
+    }
+
+    DBPF::ThreadPool pool(3);
+    {
+        // A small in-flight budget forces entries out while later ones are still compressing.
+        DBPF::Writer writer(&pool, 4096);
+        REQUIRE(writer.Open(path));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            REQUIRE(writer.Add(entries[i].first, std::span<const uint8_t>(entries[i].second), i % 2 == 0));
+        }
+        CHECK_FALSE(writer.Add(DBPF::kDirectoryTgi, std::vector<uint8_t>{1, 2, 3}));
+        REQUIRE(writer.Finish());
+    }
+
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadFile(path));
+    CHECK(reader.GetHeader().indexType == 7);
+    REQUIRE(reader.GetIndex().size() == entries.size() + 1);
+    CHECK(reader.HasDirectory());
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& [tgi, data] = entries[i];
+        const auto* entry = reader.FindEntry(tgi);
+        REQUIRE(entry != nullptr);
+        CHECK(reader.ReadEntryData(*entry) == data);
+
+        const bool expectCompressed = i % 2 == 0 && i % 5 != 0;
+        CHECK(reader.IsCompressed(*entry) == expectCompressed);
+        if (expectCompressed) {
+            CHECK(entry->decompressedSize == data.size());
+            CHECK(entry->size < data.size());
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Synthetic archives are deterministic and parse with every loader") {
+    const auto dir = std::filesystem::temp_directory_path() / "dbpfkit_synthetic";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto readBytes = [](const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+    };
+
+    Synthetic::ArchiveSpec spec;
+    spec.seed = 42;
+    spec.entryCount = 120;
+    spec.includeRul0 = true;
+    DBPF::ThreadPool pool(3);
+    const auto summary = Synthetic::WriteArchive(dir / "a.dat", spec, &pool);
+    REQUIRE(summary.has_value());
+    CHECK(summary->entries == spec.entryCount + 1);
+    REQUIRE(Synthetic::WriteArchive(dir / "b.dat", spec, &pool));
+    CHECK(readBytes(dir / "a.dat") == readBytes(dir / "b.dat"));
+    spec.seed = 43;
+    REQUIRE(Synthetic::WriteArchive(dir / "c.dat", spec, &pool));
+    CHECK(readBytes(dir / "a.dat") != readBytes(dir / "c.dat"));
+
+    for (const bool withDirectory : {true, false}) {
+        spec.writeDirectory = withDirectory;
+        REQUIRE(Synthetic::WriteArchive(dir / "d.dat", spec, &pool));
+        DBPF::Reader reader;
+        REQUIRE(reader.LoadFile(dir / "d.dat"));
+        CHECK(reader.HasDirectory() == withDirectory);
+        CHECK(reader.GetIndex().size() == spec.entryCount + 1 + (withDirectory ? 1 : 0));
+
+        size_t compressed = 0;
+        for (const auto& entry : reader.GetIndex()) {
+            compressed += reader.IsCompressed(entry);
+            switch (entry.tgi.type) {
+            case 0x6534284A:
+                CHECK(reader.LoadExemplar(entry).has_value());
+                break;
+            case 0x7AB50E44:
+                CHECK(reader.LoadFSH(entry).has_value());
+                break;
+            case 0x5AD0E817:
+                CHECK(reader.LoadS3D(entry).has_value());
+                break;
+            case 0x2026960B:
+                CHECK(reader.LoadLText(entry).has_value());
+                break;
+            case 0x0A5BCF4B: {
+                const auto rul0 = reader.LoadRUL0(entry);
+                REQUIRE(rul0.has_value());
+                CHECK(rul0->puzzlePieces.size() == rul0->orderings.size() * 4);
+                break;
+            }
+            default:
+                CHECK(entry.tgi == DBPF::kDirectoryTgi);
+                break;
+            }
+        }
+        CHECK(compressed > 0);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Synthetic plugin trees load into a plugin set") {
+    const auto root = std::filesystem::temp_directory_path() / "dbpfkit_synthetic_tree";
+    std::filesystem::remove_all(root);
+
+    Synthetic::TreeSpec spec;
+    spec.fileCount = 40;
+    spec.filesPerDirectory = 6;
+    spec.minEntries = 5;
+    spec.maxEntries = 30;
+    spec.threadCount = 4;
+    // A small instance space makes later files override earlier ones.
+    spec.archive.instanceSpace = 64;
+    DBPF::ThreadPool pool(2);
+    const auto summary = Synthetic::WriteTree(root, spec, &pool);
+    REQUIRE(summary.has_value());
+    CHECK(summary->files == spec.fileCount);
+    CHECK(summary->entries >= spec.fileCount * spec.minEntries);
+
+    const auto files = DBPF::PluginSet::CollectPluginFiles(root);
+    CHECK(files.size() == spec.fileCount);
+
+    DBPF::PluginSet plugins;
+    const std::array roots{root};
+    CHECK(plugins.LoadDirectories(roots, &pool) == spec.fileCount);
+    CHECK(plugins.GetFailedFiles().empty());
+    CHECK(plugins.EntryCount() < summary->entries);
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Thread pool runs nested parallel loops to completion") {
+    DBPF::ThreadPool pool(3);
+    std::vector<std::atomic<int>> counts(100);
+    pool.ParallelFor(10, [&](size_t outer) {
+        pool.ParallelFor(10, [&](size_t inner) {
+            counts[outer * 10 + inner].fetch_add(1);
+        });
+    });
+    for (const auto& count : counts) {
+        CHECK(count.load() == 1);
+    }
+
+    CHECK_FALSE(pool.CurrentWorkerIndex().has_value());
+    std::vector<std::atomic<int>> seenWorkers(pool.Size());
+    pool.ParallelFor(64, [&](size_t) {
+        if (const auto index = pool.CurrentWorkerIndex()) {
+            REQUIRE(*index < pool.Size());
+            seenWorkers[*index].fetch_add(1);
+        }
+    });
+}
+
 TEST_CASE("DBPF reader finds entries via masks and catalog labels") {
     const DBPF::Tgi fshTgi{0x7AB50E44, 0x0986135E, 0x00000011};
     const DBPF::Tgi s3dTgi{0x5AD0E817, 0xBADB57F1, 0x00000001};
@@ -421,6 +1634,126 @@ TEST_CASE("DBPF reader finds entries via masks and catalog labels") {
     REQUIRE(*s3dBytes == std::vector<uint8_t>{'3', 'D', '!'});
 }
 
+TEST_CASE("TGI index resolves exact lookups and partial masks") {
+    std::vector<DBPF::IndexEntry> entries;
+    auto add = [&](uint32_t type, uint32_t group, uint32_t instance, uint32_t offset) {
+        DBPF::IndexEntry entry;
+        entry.tgi = DBPF::Tgi{type, group, instance};
+        entry.offset = offset;
+        entries.push_back(entry);
+    };
+    add(0x20, 0x2, 0x1, 0);
+    add(0x10, 0x1, 0x2, 1);
+    add(0x10, 0x2, 0x1, 2);
+    add(0x10, 0x1, 0x1, 3);
+    add(0x10, 0x1, 0x2, 4); // duplicate TGI, the earlier entry wins
+
+    DBPF::TgiIndex index;
+    index.Build(entries);
+    REQUIRE(index.Size() == entries.size());
+
+    CHECK(index.Find(DBPF::Tgi{0x10, 0x1, 0x2}) == 1u);
+    CHECK(index.Find(DBPF::Tgi{0x20, 0x2, 0x1}) == 0u);
+    CHECK_FALSE(index.Find(DBPF::Tgi{0x10, 0x3, 0x1}).has_value());
+
+    auto matching = [&](std::optional<uint32_t> type, std::optional<uint32_t> group,
+                        std::optional<uint32_t> instance) {
+        DBPF::TgiMask mask;
+        mask.type = type;
+        mask.group = group;
+        mask.instance = instance;
+        std::vector<uint32_t> positions;
+        index.FindMatching(mask, positions);
+        std::ranges::sort(positions);
+        return positions;
+    };
+
+    CHECK(matching(0x10, std::nullopt, std::nullopt) == std::vector<uint32_t>{1, 2, 3, 4});
+    CHECK(matching(0x10, 0x1, std::nullopt) == std::vector<uint32_t>{1, 3, 4});
+    CHECK(matching(0x10, std::nullopt, 0x1) == std::vector<uint32_t>{2, 3});
+    CHECK(matching(std::nullopt, 0x2, std::nullopt) == std::vector<uint32_t>{0, 2});
+    CHECK(matching(std::nullopt, 0x2, 0x1) == std::vector<uint32_t>{0, 2});
+    CHECK(matching(std::nullopt, std::nullopt, 0x2) == std::vector<uint32_t>{1, 4});
+    CHECK(matching(std::nullopt, std::nullopt, std::nullopt).size() == entries.size());
+    CHECK(matching(0x30, std::nullopt, std::nullopt).empty());
+
+    index.Clear();
+    CHECK(index.Empty());
+    CHECK_FALSE(index.Find(DBPF::Tgi{0x10, 0x1, 0x2}).has_value());
+}
+
+TEST_CASE("TGI index agrees with a linear filter for every mask shape") {
+    std::vector<DBPF::IndexEntry> entries(2051);
+    uint32_t state = 12345;
+    auto next = [&](uint32_t range) {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) % range;
+    };
+    for (auto& entry : entries) {
+        // Instance 0 is common enough to take the scan path; the others are rare enough to be intersected.
+        entry.tgi = DBPF::Tgi{next(5), next(13), next(2) == 0 ? 0u : next(251)};
+    }
+
+    DBPF::TgiIndex index;
+    index.Build(entries);
+
+    const std::array<std::optional<uint32_t>, 2> types{std::nullopt, 3u};
+    const std::array<std::optional<uint32_t>, 3> groups{std::nullopt, 7u, 99u};
+    const std::array<std::optional<uint32_t>, 3> instances{std::nullopt, 42u, 0u};
+    for (const auto& type : types) {
+        for (const auto& group : groups) {
+            for (const auto& instance : instances) {
+                DBPF::TgiMask mask;
+                mask.type = type;
+                mask.group = group;
+                mask.instance = instance;
+
+                std::vector<uint32_t> expected;
+                for (uint32_t i = 0; i < entries.size(); ++i) {
+                    if (mask.Matches(entries[i].tgi)) {
+                        expected.push_back(i);
+                    }
+                }
+                std::vector<uint32_t> actual;
+                index.FindMatching(mask, actual);
+                CHECK(actual == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Reader mask lookups return matches in index order") {
+    // The first entry in the archive sorts last by TGI, so TGI order would pick a different first match.
+    const DBPF::Tgi late{0x10, 0x9, 0x9};
+    const DBPF::Tgi early{0x10, 0x1, 0x1};
+    const DBPF::Tgi middle{0x10, 0x5, 0x1};
+    const std::vector<TestEntry> entries{
+        TestEntry{late, {1}},
+        TestEntry{middle, {2}},
+        TestEntry{early, {3}},
+    };
+    auto buffer = BuildDbpf(entries);
+
+    DBPF::Reader reader;
+    REQUIRE(reader.LoadBuffer(buffer.data(), buffer.size()));
+
+    DBPF::TgiMask byType;
+    byType.type = 0x10;
+    const auto matches = reader.FindEntries(byType);
+    REQUIRE(matches.size() == 3);
+    CHECK(matches[0]->tgi == late);
+    CHECK(matches[1]->tgi == middle);
+    CHECK(matches[2]->tgi == early);
+    CHECK(reader.ReadFirstMatching(byType) == std::vector<uint8_t>{1});
+
+    DBPF::TgiMask byInstance;
+    byInstance.instance = 0x1;
+    const auto byInstanceMatches = reader.FindEntries(byInstance);
+    REQUIRE(byInstanceMatches.size() == 2);
+    CHECK(byInstanceMatches[0]->tgi == middle);
+    CHECK(byInstanceMatches[1]->tgi == early);
+}
+
 TEST_CASE("DBPF typed loaders parse FSH and Exemplar entries") {
     const DBPF::Tgi fshTgi{0x7AB50E44, 0x0986135E, 0x0000F00D};
     const DBPF::Tgi exemplarTgi{0x6534284A, 0x2821ED93, 0x12345678};
@@ -591,6 +1924,101 @@ TEST_CASE("Exemplar parser decodes signed hex literals in text exemplars") {
     CHECK(std::get<int32_t>(prop->values[1]) == 10);
 }
 
+TEST_CASE("ExemplarView reads binary properties in place") {
+    std::vector<std::vector<uint8_t>> properties;
+    properties.push_back(MakeSingleUInt32Property(0x12345678, 0xCAFEBABE));
+    properties.push_back(MakeMultiFloatProperty(0x87654321, {1.0f, 2.5f, -4.0f}));
+    properties.push_back(MakeStringProperty(0x0000DEAD, "Test"));
+
+    std::vector<uint8_t> stringArray;
+    AppendRaw(stringArray, static_cast<uint32_t>(0x0000BEEF));
+    WriteUInt16LE(stringArray, 0x0C00); // String
+    WriteUInt16LE(stringArray, 0x0081); // string array
+    stringArray.push_back(0);
+    AppendRaw(stringArray, static_cast<uint32_t>(2 * 4 + 5)); // total length
+    AppendRaw(stringArray, static_cast<uint32_t>(2));         // entry count
+    AppendRaw(stringArray, static_cast<uint32_t>(2));
+    AppendRaw(stringArray, static_cast<uint32_t>(3));
+    for (const char ch : std::string_view("abxyz")) {
+        stringArray.push_back(static_cast<uint8_t>(ch));
+    }
+    properties.push_back(stringArray);
+
+    const auto buffer = BuildExemplarBuffer(properties);
+    const auto view = Exemplar::ExemplarView::Parse(buffer);
+    REQUIRE(view.has_value());
+    REQUIRE(view->Properties().size() == 4);
+    CHECK(view->Find(0x11111111) == nullptr);
+
+    CHECK(view->GetScalarAs<uint32_t>(0x12345678) == 0xCAFEBABE);
+    CHECK(view->GetScalarAs<int64_t>(0x12345678) == 0xCAFEBABE);
+    CHECK_FALSE(view->GetScalarAs<float>(0x12345678).has_value());
+    CHECK_FALSE(view->GetScalarAs<uint32_t>(0x12345678, 1).has_value());
+
+    const auto floats = view->GetValues<float>(0x87654321);
+    REQUIRE(floats.has_value());
+    CHECK(floats->ToVector() == std::vector<float>{1.0f, 2.5f, -4.0f});
+    CHECK_FALSE(view->GetValues<uint32_t>(0x87654321).has_value());
+    CHECK(view->GetScalarAs<float>(0x87654321, 2) == -4.0f);
+
+    const auto text = view->GetString(0x0000DEAD);
+    REQUIRE(text.has_value());
+    CHECK(*text == "Test");
+    CHECK(text->data() == reinterpret_cast<const char*>(buffer.data()) + view->Find(0x0000DEAD)->offset);
+
+    const auto* array = view->Find(0x0000BEEF);
+    REQUIRE(array != nullptr);
+    CHECK(array->isList);
+    CHECK(array->count == 2);
+    CHECK(view->GetString(*array, 0) == "ab");
+    CHECK(view->GetString(*array, 1) == "xyz");
+    CHECK_FALSE(view->GetString(*array, 2).has_value());
+
+    auto truncated = buffer;
+    truncated.resize(truncated.size() - 1);
+    CHECK_FALSE(Exemplar::ExemplarView::Parse(truncated).has_value());
+
+    const std::string textExemplar = "EQZT1###\nParentCohort=Key:{0x00000000,0x00000000,0x00000000}\nPropCount=0x00000000\n";
+    const std::vector<uint8_t> textBuffer(textExemplar.begin(), textExemplar.end());
+    CHECK_FALSE(Exemplar::ExemplarView::Parse(textBuffer).has_value());
+}
+
+TEST_CASE("ExemplarView agrees with the materializing parser") {
+    Synthetic::Rng rng(17);
+    for (int sample = 0; sample < 20; ++sample) {
+        const auto buffer = Synthetic::MakeExemplar(rng, 1 + rng.Below(60));
+        const auto record = Exemplar::Parse(buffer);
+        const auto view = Exemplar::ExemplarView::Parse(buffer);
+        REQUIRE(record.has_value());
+        REQUIRE(view.has_value());
+        REQUIRE(view->Properties().size() == record->properties.size());
+
+        for (size_t i = 0; i < record->properties.size(); ++i) {
+            const auto& property = record->properties[i];
+            const auto& info = view->Properties()[i];
+            CHECK(info.id == property.id);
+            CHECK(info.type == property.type);
+            CHECK(info.isList == property.isList);
+            if (property.IsString()) {
+                CHECK(view->GetString(info) == std::get<std::string>(property.values.front()));
+                continue;
+            }
+            REQUIRE(info.count == property.values.size());
+            for (size_t j = 0; j < property.values.size(); ++j) {
+                if (property.type == Exemplar::ValueType::Float32) {
+                    CHECK(view->GetScalarAs<float>(property.id, j) == property.GetScalarAs<float>(j));
+                }
+                else if (property.type == Exemplar::ValueType::Bool) {
+                    CHECK(view->GetScalarAs<bool>(property.id, j) == property.GetScalarAs<bool>(j));
+                }
+                else {
+                    CHECK(view->GetScalarAs<int64_t>(property.id, j) == property.GetScalarAs<int64_t>(j));
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("LText parser decodes UTF-16 payloads") {
     std::u16string text = u"City ";
     text.push_back(static_cast<char16_t>(0xD83D));